@@ -0,0 +1,298 @@
+#include "ini.h"
+#include "SimpleINI.h"
+#include "SimpleINIStats.h"
+#include "HAL/FileManager.h"
+#include "Misc/Crc.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+namespace
+{
+	const uint32 ImageMagic = 0x42494E49;	// "INIB"
+	const uint32 ImageVersion = 2;
+
+	// What the image was made from, and the layout of the records it holds. An image
+	// only loads on a build with the same record layout.
+	struct FImageHeader
+	{
+		uint32 Magic;
+		uint32 Version;
+		uint32 CharSize;
+		uint32 SectionSize;
+		uint32 EntrySize;
+		int64 SourceSize;
+		int64 SourceTicks;
+		uint32 SourceCrc;
+		uint32 PayloadCrc;
+
+		FImageHeader( )
+			: Magic( ImageMagic )
+			, Version( ImageVersion )
+			, CharSize( sizeof( TCHAR ) )
+			, SectionSize( sizeof( IniSection ) )
+			, EntrySize( sizeof( IniSectionContentEntry ) )
+			, SourceSize( 0 )
+			, SourceTicks( 0 )
+			, SourceCrc( 0 )
+			, PayloadCrc( 0 )
+		{
+		}
+
+		friend FArchive& operator<<( FArchive& Ar, FImageHeader& Header )
+		{
+			Ar << Header.Magic << Header.Version << Header.CharSize << Header.SectionSize << Header.EntrySize;
+			Ar << Header.SourceSize << Header.SourceTicks << Header.SourceCrc << Header.PayloadCrc;
+			return Ar;
+		}
+	};
+
+	// records are plain data, so an array is stored as its count and its bytes
+	template <typename RecordType>
+	void SerializeRecords( FArchive& Ar, TArray<RecordType>& Records )
+	{
+		int32 Num = Records.Num( );
+		Ar << Num;
+		if (Ar.IsLoading( ))
+		{
+			if (Num < 0 || (int64)Num * sizeof( RecordType ) > Ar.TotalSize( ) - Ar.Tell( ))
+			{
+				Ar.SetError( );
+				return;
+			}
+			Records.SetNumUninitialized( Num );
+		}
+		Ar.Serialize( Records.GetData( ), (int64)Num * sizeof( RecordType ) );
+	}
+
+	bool IsIndex( int32 Index, int32 Num )
+	{
+		return Index == INDEX_NONE || (Index >= 0 && Index < Num);
+	}
+
+	bool IsString( IniStringRef Ref, int32 NumChars )
+	{
+		return Ref.Len == 0 || (Ref.Offset >= 0 && Ref.Len > 0 && Ref.Offset <= NumChars - Ref.Len);
+	}
+
+	bool IsBucketArray( const TArray<int32>& Buckets, int32 Num )
+	{
+		if (Buckets.Num( ) == 0 || !FMath::IsPowerOfTwo( Buckets.Num( ) ))
+		{
+			return false;
+		}
+		for (int i = 0; i < Buckets.Num( ); ++i)
+		{
+			if (!IsIndex( Buckets[i], Num ))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	FString GetImagePath( const FString& FilePath, const FString& CacheDir )
+	{
+		if (CacheDir.IsEmpty( ))
+		{
+			return FilePath + TEXT( ".inib" );
+		}
+		// files of the same name from different directories get different images
+		const FString FullPath = FPaths::ConvertRelativePathToFull( FilePath );
+		return FPaths::Combine( CacheDir, FString::Printf( TEXT( "%s-%08x.inib" ), *FPaths::GetCleanFilename( FilePath ), FCrc::StrCrc32( *FullPath ) ) );
+	}
+
+	TSharedPtr<IniRoot> ReadImage( const FString& ImagePath, const FImageHeader& Expected )
+	{
+		TArray<uint8> Bytes;
+		if (IFileManager::Get( ).FileSize( *ImagePath ) <= 0 || !FFileHelper::LoadFileToArray( Bytes, *ImagePath, FILEREAD_Silent ))
+		{
+			return nullptr;
+		}
+
+		FMemoryReader Reader( Bytes );
+		FImageHeader Header;
+		Reader << Header;
+		if (Reader.IsError( )
+			|| Header.Magic != Expected.Magic || Header.Version != Expected.Version
+			|| Header.CharSize != Expected.CharSize || Header.SectionSize != Expected.SectionSize || Header.EntrySize != Expected.EntrySize
+			|| Header.SourceSize != Expected.SourceSize || Header.SourceTicks != Expected.SourceTicks || Header.SourceCrc != Expected.SourceCrc)
+		{
+			return nullptr;
+		}
+		const int64 PayloadStart = Reader.Tell( );
+		if (FCrc::MemCrc32( Bytes.GetData( ) + PayloadStart, Bytes.Num( ) - PayloadStart ) != Header.PayloadCrc)
+		{
+			UE_LOG( LogSimpleINI, Warning, TEXT( "%s is damaged, rebuilding it" ), *ImagePath );
+			return nullptr;
+		}
+
+		TSharedPtr<IniRoot> NewRoot( new IniRoot( ) );
+		NewRoot->SerializeImage( Reader );
+		return Reader.IsError( ) ? nullptr : NewRoot;
+	}
+
+	void WriteImage( const FString& ImagePath, IniRoot& Root, FImageHeader& Header )
+	{
+		TArray<uint8> Payload;
+		FMemoryWriter PayloadWriter( Payload );
+		Root.SerializeImage( PayloadWriter );
+		Header.PayloadCrc = FCrc::MemCrc32( Payload.GetData( ), Payload.Num( ) );
+
+		TArray<uint8> Bytes;
+		FMemoryWriter Writer( Bytes );
+		Writer << Header;
+		Bytes.Append( Payload );
+
+		// readers never see a half written image
+		const FString TempPath = ImagePath + TEXT( ".tmp" );
+		if (!FFileHelper::SaveArrayToFile( Bytes, *TempPath ) || !IFileManager::Get( ).Move( *ImagePath, *TempPath, true ))
+		{
+			UE_LOG( LogSimpleINI, Warning, TEXT( "Cannot write %s" ), *ImagePath );
+			IFileManager::Get( ).Delete( *TempPath, false, false, true );
+		}
+	}
+}
+
+void IniRoot::SerializeImage( FArchive& Ar )
+{
+	check( Ar.IsLoading( ) || (!HasPendingSections( ) && !Source && !bUtf8) );
+
+	int64 TimeStampTicks = FileTimeStamp.GetTicks( );
+	Ar << FileOrigin << bFileLayoutKnown << FileSize << TimeStampTicks;
+	SerializeRecords( Ar, Chars );
+	SerializeRecords( Ar, Sections );
+	SerializeRecords( Ar, Entries );
+	SerializeRecords( Ar, SectionIndexLevel );
+	SerializeRecords( Ar, NameIndexLevel );
+	if (!Ar.IsLoading( ) || Ar.IsError( ))
+	{
+		return;
+	}
+	FileTimeStamp = FDateTime( TimeStampTicks );
+
+	// a consistent image cannot make lookups read outside the arrays
+	bool bValid = Sections.Num( ) > 0 && Sections[0].IsVirtual
+		&& IsBucketArray( SectionIndexLevel, Sections.Num( ) ) && IsBucketArray( NameIndexLevel, Entries.Num( ) );
+	for (int i = 0; bValid && i < Sections.Num( ); ++i)
+	{
+		const IniSection& Section = Sections[i];
+		bValid = Section.bParsed
+			&& IsIndex( Section.FirstEntry, Entries.Num( ) ) && IsIndex( Section.LastEntry, Entries.Num( ) ) && IsIndex( Section.HashNext, Sections.Num( ) )
+			&& IsString( Section.Raw, Chars.Num( ) ) && IsString( Section.Name, Chars.Num( ) );
+	}
+	for (int i = 0; bValid && i < Entries.Num( ); ++i)
+	{
+		const IniSectionContentEntry& Entry = Entries[i];
+		bValid = Entry.Section >= 0 && Entry.Section < Sections.Num( )
+			&& IsIndex( Entry.Next, Entries.Num( ) ) && IsIndex( Entry.HashNext, Entries.Num( ) )
+			&& IsString( Entry.Raw, Chars.Num( ) ) && IsString( Entry.Name, Chars.Num( ) ) && IsString( Entry.Value, Chars.Num( ) );
+	}
+
+	// every chain has to end: a record is on one bucket chain at most and in the entry
+	// list of its own section only, so a walk that meets a record twice found a loop
+	TBitArray<> Seen( false, Sections.Num( ) );
+	for (int i = 0; bValid && i < SectionIndexLevel.Num( ); ++i)
+	{
+		for (int32 SectionIndex = SectionIndexLevel[i]; bValid && SectionIndex != INDEX_NONE; SectionIndex = Sections[SectionIndex].HashNext)
+		{
+			bValid = !Seen[SectionIndex];
+			Seen[SectionIndex] = true;
+		}
+	}
+	Seen.Init( false, Entries.Num( ) );
+	for (int i = 0; bValid && i < NameIndexLevel.Num( ); ++i)
+	{
+		for (int32 EntryIndex = NameIndexLevel[i]; bValid && EntryIndex != INDEX_NONE; EntryIndex = Entries[EntryIndex].HashNext)
+		{
+			bValid = !Seen[EntryIndex];
+			Seen[EntryIndex] = true;
+		}
+	}
+	Seen.Init( false, Entries.Num( ) );
+	for (int i = 0; bValid && i < Sections.Num( ); ++i)
+	{
+		const IniSection& Section = Sections[i];
+		int32 LastEntry = INDEX_NONE;
+		int32 NumEntries = 0;
+		for (int32 EntryIndex = Section.FirstEntry; bValid && EntryIndex != INDEX_NONE; EntryIndex = Entries[EntryIndex].Next)
+		{
+			bValid = !Seen[EntryIndex] && Entries[EntryIndex].Section == i;
+			Seen[EntryIndex] = true;
+			LastEntry = EntryIndex;
+			++NumEntries;
+		}
+		bValid = bValid && LastEntry == Section.LastEntry && NumEntries == Section.NumEntries;
+	}
+	if (!bValid)
+	{
+		Ar.SetError( );
+		return;
+	}
+
+	// name ids only hold in the process that interned them
+	for (IniSection& Section : Sections)
+	{
+		Section.NameId = Section.IsVirtual ? 0 : InternName( GetChars( Section.Name ), Section.Name.Len, Section.NameHash );
+	}
+	for (IniSectionContentEntry& Entry : Entries)
+	{
+		if (Entry.SubType == eNameValuePair || Entry.SubType == eOnlyName)
+		{
+			Entry.NameId = InternName( GetChars( Entry.Name ), Entry.Name.Len, Entry.NameHash );
+		}
+	}
+}
+
+bool IniFile::LoadFileCached( const FString& FilePath, const FString& CacheDir /*= FString( )*/ )
+{
+	SCOPE_CYCLE_COUNTER( STAT_IniLoad );
+	SCOPED_NAMED_EVENT_FSTRING( FilePath, FColor::Turquoise );
+	const double StartTime = FPlatformTime::Seconds( );
+
+	// the source is still read: its CRC is what proves the image current
+	TArray<uint8> Bytes;
+	if (!FFileHelper::LoadFileToArray( Bytes, *FilePath ))
+	{
+		return AdoptRoot( FilePath, nullptr, 0.0 );
+	}
+	INC_DWORD_STAT_BY( STAT_IniBytesRead, Bytes.Num( ) );
+	const FDateTime TimeStamp = IFileManager::Get( ).GetTimeStamp( *FilePath );
+
+	if (bCompactStorage)
+	{
+		// images hold TCHAR text, a compact document is parsed from the file every time
+		double ParseSeconds = 0.0;
+		TSharedPtr<IniRoot> NewRoot = ParseBytesCompact( MoveTemp( Bytes ), ParseSeconds );
+		if (NewRoot)
+		{
+			NewRoot->FileTimeStamp = TimeStamp;
+		}
+		return AdoptRoot( FilePath, NewRoot, FPlatformTime::Seconds( ) - StartTime );
+	}
+
+	FImageHeader Header;
+	Header.SourceSize = Bytes.Num( );
+	Header.SourceTicks = TimeStamp.GetTicks( );
+	Header.SourceCrc = FCrc::MemCrc32( Bytes.GetData( ), Bytes.Num( ) );
+
+	const FString ImagePath = GetImagePath( FilePath, CacheDir );
+	TSharedPtr<IniRoot> NewRoot = ReadImage( ImagePath, Header );
+	if (NewRoot)
+	{
+		NewRoot->SourceBytes = Bytes.Num( );
+		UE_LOG( LogSimpleINI, Verbose, TEXT( "Loaded %s from %s" ), *FilePath, *ImagePath );
+	}
+	else
+	{
+		double ParseSeconds = 0.0;
+		NewRoot = ParseBytes( Bytes, ParseSeconds );
+		if (NewRoot)
+		{
+			NewRoot->FileTimeStamp = TimeStamp;
+			WriteImage( ImagePath, *NewRoot, Header );
+		}
+	}
+	return AdoptRoot( FilePath, NewRoot, FPlatformTime::Seconds( ) - StartTime );
+}
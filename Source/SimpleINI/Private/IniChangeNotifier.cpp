@@ -0,0 +1,183 @@
+#include "IniChangeNotifier.h"
+#include "Async/Async.h"
+#include "Misc/ScopeLock.h"
+#include "Misc/ScopeRWLock.h"
+#include "IniRegistry.h"
+
+FIniChangeNotifier& FIniChangeNotifier::Get( )
+{
+	static FIniChangeNotifier Notifier;
+	return Notifier;
+}
+
+void FIniChangeNotifier::UpdateRecording( const FString& PathKey ) const
+{
+	// Called without Lock: a file's lock is taken before Lock, never while holding it.
+	// Reading the subscribers under the file lock makes the last of several racing
+	// updates leave the file with the current answer. Files opened later ask
+	// HasSubscribers themselves.
+	if (IniFilePtr Ini = FIniRegistry::Get( ).Find( PathKey ))
+	{
+		FWriteScopeLock WriteLock( Ini->GetLock( ) );
+		Ini->SetRecordChanges( HasSubscribers( PathKey ) );
+	}
+}
+
+FDelegateHandle FIniChangeNotifier::SubscribeFile( const FString& FilePath, const FOnValueChanged::FDelegate& Delegate )
+{
+	const FString PathKey = FIniRegistry::NormalizePath( FilePath );
+	FDelegateHandle Handle;
+	{
+		FScopeLock ScopeLock( &Lock );
+		Handle = Subscribers.FindOrAdd( PathKey ).File.Add( Delegate );
+	}
+	UpdateRecording( PathKey );
+	return Handle;
+}
+
+FDelegateHandle FIniChangeNotifier::SubscribeSection( const FString& FilePath, const FString& SectionName, const FOnValueChanged::FDelegate& Delegate )
+{
+	const FString PathKey = FIniRegistry::NormalizePath( FilePath );
+	FDelegateHandle Handle;
+	{
+		FScopeLock ScopeLock( &Lock );
+		Handle = Subscribers.FindOrAdd( PathKey ).Sections.FindOrAdd( SectionName ).Add( Delegate );
+	}
+	UpdateRecording( PathKey );
+	return Handle;
+}
+
+FDelegateHandle FIniChangeNotifier::SubscribeKey( const FString& FilePath, const FString& SectionName, const FString& Name, const FOnValueChanged::FDelegate& Delegate )
+{
+	const FString PathKey = FIniRegistry::NormalizePath( FilePath );
+	FDelegateHandle Handle;
+	{
+		FScopeLock ScopeLock( &Lock );
+		Handle = Subscribers.FindOrAdd( PathKey ).Keys.FindOrAdd( MakeTuple( SectionName, Name ) ).Add( Delegate );
+	}
+	UpdateRecording( PathKey );
+	return Handle;
+}
+
+void FIniChangeNotifier::Unsubscribe( FDelegateHandle Handle )
+{
+	// files whose last subscriber went away stop recording
+	TArray<FString> Emptied;
+	{
+		FScopeLock ScopeLock( &Lock );
+		for (auto FileIt = Subscribers.CreateIterator( ); FileIt; ++FileIt)
+		{
+			FFileSubscribers& File = FileIt.Value( );
+			File.File.Remove( Handle );
+			for (auto It = File.Sections.CreateIterator( ); It; ++It)
+			{
+				if (It.Value( ).Remove( Handle ) && !It.Value( ).IsBound( ))
+				{
+					It.RemoveCurrent( );
+				}
+			}
+			for (auto It = File.Keys.CreateIterator( ); It; ++It)
+			{
+				if (It.Value( ).Remove( Handle ) && !It.Value( ).IsBound( ))
+				{
+					It.RemoveCurrent( );
+				}
+			}
+			if (!File.File.IsBound( ) && File.Sections.Num( ) == 0 && File.Keys.Num( ) == 0)
+			{
+				Emptied.Add( FileIt.Key( ) );
+				FileIt.RemoveCurrent( );
+			}
+		}
+	}
+	for (const FString& PathKey : Emptied)
+	{
+		UpdateRecording( PathKey );
+	}
+}
+
+bool FIniChangeNotifier::HasSubscribers( const FString& PathKey ) const
+{
+	FScopeLock ScopeLock( &Lock );
+	return Subscribers.Contains( PathKey );
+}
+
+void FIniChangeNotifier::Broadcast( const FString& PathKey, TArray<IniValueChange>&& Changes )
+{
+	if (Changes.Num( ) == 0)
+	{
+		return;
+	}
+	if (!IsInGameThread( ))
+	{
+		AsyncTask( ENamedThreads::GameThread, [this, PathKey, Changes = MoveTemp( Changes )]( ) mutable
+		{
+			Broadcast( PathKey, MoveTemp( Changes ) );
+		} );
+		return;
+	}
+
+	// a copy, so handlers can subscribe and unsubscribe
+	FFileSubscribers File;
+	{
+		FScopeLock ScopeLock( &Lock );
+		const FFileSubscribers* Found = Subscribers.Find( PathKey );
+		if (!Found)
+		{
+			return;
+		}
+		File = *Found;
+	}
+
+	for (const IniValueChange& Change : Changes)
+	{
+		File.File.Broadcast( PathKey, Change );
+		if (const FOnValueChanged* Section = File.Sections.Find( Change.SectionName ))
+		{
+			Section->Broadcast( PathKey, Change );
+		}
+		if (const FOnValueChanged* Key = File.Keys.Find( MakeTuple( Change.SectionName, Change.Name ) ))
+		{
+			Key->Broadcast( PathKey, Change );
+		}
+	}
+}
+
+void UIniChangeSubscription::Subscribe( const FString& FilePath, const FString& SectionName, const FString& Key )
+{
+	Unsubscribe( );
+
+	const FIniChangeNotifier::FOnValueChanged::FDelegate Delegate = FIniChangeNotifier::FOnValueChanged::FDelegate::CreateUObject( this, &UIniChangeSubscription::HandleValueChanged );
+	if (!Key.IsEmpty( ))
+	{
+		Handle = FIniChangeNotifier::Get( ).SubscribeKey( FilePath, SectionName, Key, Delegate );
+	}
+	else if (!SectionName.IsEmpty( ))
+	{
+		Handle = FIniChangeNotifier::Get( ).SubscribeSection( FilePath, SectionName, Delegate );
+	}
+	else
+	{
+		Handle = FIniChangeNotifier::Get( ).SubscribeFile( FilePath, Delegate );
+	}
+}
+
+void UIniChangeSubscription::Unsubscribe( )
+{
+	if (Handle.IsValid( ))
+	{
+		FIniChangeNotifier::Get( ).Unsubscribe( Handle );
+		Handle.Reset( );
+	}
+}
+
+void UIniChangeSubscription::BeginDestroy( )
+{
+	Unsubscribe( );
+	Super::BeginDestroy( );
+}
+
+void UIniChangeSubscription::HandleValueChanged( const FString& FilePath, const IniValueChange& Change )
+{
+	OnValueChanged.Broadcast( Change.SectionName, Change.Name, Change.OldValue, Change.NewValue );
+}
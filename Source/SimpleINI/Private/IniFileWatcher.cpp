@@ -0,0 +1,352 @@
+#include "IniFileWatcher.h"
+#include "Async/Async.h"
+#include "Containers/Ticker.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeRWLock.h"
+#include "IniChangeNotifier.h"
+#include "IniRegistry.h"
+#include "SimpleINI.h"
+
+#if PLATFORM_LINUX
+#include <errno.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	const float TickInterval = 0.1f;
+	// how often files opened or closed since the last look are picked up
+	const double SyncInterval = 1.0;
+
+	void WarnUnsavedChanges( const IniFile& File )
+	{
+		UE_LOG( LogSimpleINI, Warning, TEXT( "%s changed on disk, not reloading over the unsaved changes made to it" ), *File.mFilePath );
+	}
+}
+
+FIniFileWatcher& FIniFileWatcher::Get( )
+{
+	static FIniFileWatcher Watcher;
+	return Watcher;
+}
+
+FIniFileWatcher::FIniFileWatcher( )
+	: DebounceSeconds( 0.25f )
+	, LastSyncTime( 0.0 )
+	, NotifyFd( -1 )
+{
+}
+
+FIniFileWatcher::~FIniFileWatcher( )
+{
+	Stop( );
+}
+
+void FIniFileWatcher::Start( float InDebounceSeconds /*= 0.25f*/ )
+{
+	DebounceSeconds = FMath::Max( InDebounceSeconds, 0.0f );
+	if (IsRunning( ))
+	{
+		return;
+	}
+
+#if PLATFORM_LINUX
+	NotifyFd = inotify_init1( IN_NONBLOCK | IN_CLOEXEC );
+	if (NotifyFd < 0)
+	{
+		UE_LOG( LogSimpleINI, Warning, TEXT( "inotify is not available (errno %d), polling ini files instead" ), errno );
+	}
+#endif
+
+	SyncFiles( FPlatformTime::Seconds( ) );
+	TickHandle = FTicker::GetCoreTicker( ).AddTicker( FTickerDelegate::CreateRaw( this, &FIniFileWatcher::Tick ), TickInterval );
+}
+
+void FIniFileWatcher::Stop( )
+{
+	if (TickHandle.IsValid( ))
+	{
+		FTicker::GetCoreTicker( ).RemoveTicker( TickHandle );
+		TickHandle.Reset( );
+	}
+
+	for (TPair<FString, FWatchedFile>& Pair : Files)
+	{
+		if (Pair.Value.Reload.IsValid( ))
+		{
+			Pair.Value.Reload.Wait( );
+		}
+	}
+	Files.Reset( );
+
+#if PLATFORM_LINUX
+	if (NotifyFd >= 0)
+	{
+		// closing the descriptor drops every watch on it
+		close( NotifyFd );
+	}
+#endif
+	NotifyFd = -1;
+	WatchedDirectories.Reset( );
+}
+
+bool FIniFileWatcher::Tick( float DeltaTime )
+{
+	const double Now = FPlatformTime::Seconds( );
+
+	// collected first: a handler may open, close or reload files
+	TArray<TPair<FString, TArray<IniValueChange>>> Changes;
+	for (TPair<FString, FWatchedFile>& Pair : Files)
+	{
+		FWatchedFile& Watched = Pair.Value;
+		if (!Watched.Reload.IsValid( ) || !Watched.Reload.IsReady( ))
+		{
+			continue;
+		}
+		const FReloadResult& Result = Watched.Reload.Get( );
+		if (Result.Changes.Num( ) > 0)
+		{
+			Changes.Emplace( Pair.Key, Result.Changes );
+		}
+		if (Result.bRetry)
+		{
+			Watched.ChangeTime = Now;
+		}
+		Watched.Reload = TFuture<FReloadResult>( );
+	}
+
+	if (Now - LastSyncTime >= SyncInterval)
+	{
+		SyncFiles( Now );
+	}
+	ReadNotifications( Now );
+
+	for (TPair<FString, FWatchedFile>& Pair : Files)
+	{
+		FWatchedFile& Watched = Pair.Value;
+		if (Watched.ChangeTime > 0.0 && !Watched.Reload.IsValid( ) && Now - Watched.ChangeTime >= DebounceSeconds)
+		{
+			Watched.ChangeTime = 0.0;
+			IniFilePtr File = Watched.File;
+			const bool bReportChanges = ValueChanged.IsBound( ) || FIniChangeNotifier::Get( ).HasSubscribers( Pair.Key );
+			Watched.Reload = Async( EAsyncExecution::ThreadPool, [File, bReportChanges]( )
+			{
+				return ReloadFile( File, bReportChanges );
+			} );
+		}
+	}
+
+	for (TPair<FString, TArray<IniValueChange>>& FileChanges : Changes)
+	{
+		for (const IniValueChange& Change : FileChanges.Value)
+		{
+			ValueChanged.Broadcast( FileChanges.Key, Change );
+		}
+		FIniChangeNotifier::Get( ).Broadcast( FileChanges.Key, MoveTemp( FileChanges.Value ) );
+	}
+	return true;
+}
+
+void FIniFileWatcher::SyncFiles( double Now )
+{
+	LastSyncTime = Now;
+
+	TArray<TPair<FString, IniFilePtr>> Registered;
+	FIniRegistry::Get( ).GetAll( Registered );
+
+	TSet<FString> Keys;
+	for (const TPair<FString, IniFilePtr>& Pair : Registered)
+	{
+		Keys.Add( Pair.Key );
+		FWatchedFile* Watched = Files.Find( Pair.Key );
+		if (!Watched)
+		{
+			// only changes from now on count
+			Watched = &Files.Add( Pair.Key );
+			CheckFile( Pair.Key, *Watched, Now );
+			Watched->ChangeTime = 0.0;
+			Watched->WatchDescriptor = WatchDirectory( Pair.Key );
+			Watched->bPolled = (Watched->WatchDescriptor < 0);
+		}
+		else if (Watched->bPolled)
+		{
+			CheckFile( Pair.Key, *Watched, Now );
+		}
+		Watched->File = Pair.Value;
+	}
+
+	for (auto It = Files.CreateIterator( ); It; ++It)
+	{
+		if (!Keys.Contains( It.Key( ) ) && !It.Value( ).Reload.IsValid( ))
+		{
+			UnwatchDirectory( It.Value( ).WatchDescriptor );
+			It.RemoveCurrent( );
+		}
+	}
+}
+
+void FIniFileWatcher::CheckFile( const FString& FilePath, FWatchedFile& Watched, double Now )
+{
+	const FFileStatData Stat = IFileManager::Get( ).GetStatData( *FilePath );
+	const int64 Size = Stat.bIsValid ? Stat.FileSize : -1;
+	const FDateTime TimeStamp = Stat.bIsValid ? Stat.ModificationTime : FDateTime::MinValue( );
+	if (Size != Watched.Size || TimeStamp != Watched.TimeStamp)
+	{
+		Watched.Size = Size;
+		Watched.TimeStamp = TimeStamp;
+		// a deleted file is reloaded when it comes back
+		Watched.ChangeTime = Stat.bIsValid ? Now : 0.0;
+	}
+}
+
+void FIniFileWatcher::ReadNotifications( double Now )
+{
+#if PLATFORM_LINUX
+	if (NotifyFd < 0)
+	{
+		return;
+	}
+
+	alignas( inotify_event ) uint8 Buffer[4096];
+	for (;;)
+	{
+		const ssize_t Len = read( NotifyFd, Buffer, sizeof( Buffer ) );
+		if (Len <= 0)
+		{
+			break;
+		}
+		for (ssize_t Offset = 0; Offset < Len; )
+		{
+			const inotify_event* Event = (const inotify_event*)(Buffer + Offset);
+			Offset += sizeof( inotify_event ) + Event->len;
+
+			if (Event->mask & IN_Q_OVERFLOW)
+			{
+				// events were dropped, so every file is looked at
+				for (TPair<FString, FWatchedFile>& Pair : Files)
+				{
+					CheckFile( Pair.Key, Pair.Value, Now );
+				}
+			}
+			else if (Event->len > 0)
+			{
+				const FWatchedDirectory* Directory = WatchedDirectories.Find( Event->wd );
+				if (Directory)
+				{
+					const FString FilePath = Directory->Path / UTF8_TO_TCHAR( Event->name );
+					if (FWatchedFile* Watched = Files.Find( FilePath ))
+					{
+						CheckFile( FilePath, *Watched, Now );
+					}
+				}
+			}
+		}
+	}
+#endif
+}
+
+int32 FIniFileWatcher::WatchDirectory( const FString& FilePath )
+{
+#if PLATFORM_LINUX
+	if (NotifyFd < 0)
+	{
+		return -1;
+	}
+
+	// the directory is watched rather than the file, so editors that save by
+	// writing a new file and renaming it over the old one are seen too
+	const FString Directory = FPaths::GetPath( FilePath );
+	const int32 WatchDescriptor = inotify_add_watch( NotifyFd, TCHAR_TO_UTF8( *Directory ), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_MODIFY | IN_ATTRIB );
+	if (WatchDescriptor < 0)
+	{
+		UE_LOG( LogSimpleINI, Warning, TEXT( "Cannot watch %s (errno %d), polling it instead" ), *Directory, errno );
+		return -1;
+	}
+	// a directory watched already gets its descriptor back
+	FWatchedDirectory& Watched = WatchedDirectories.FindOrAdd( WatchDescriptor );
+	if (Watched.Path.IsEmpty( ))
+	{
+		Watched.Path = Directory;
+		Watched.NumFiles = 0;
+	}
+	++Watched.NumFiles;
+	return WatchDescriptor;
+#else
+	return -1;
+#endif
+}
+
+void FIniFileWatcher::UnwatchDirectory( int32 WatchDescriptor )
+{
+#if PLATFORM_LINUX
+	FWatchedDirectory* Watched = WatchedDirectories.Find( WatchDescriptor );
+	if (!Watched || --Watched->NumFiles > 0)
+	{
+		return;
+	}
+	WatchedDirectories.Remove( WatchDescriptor );
+	if (NotifyFd >= 0)
+	{
+		inotify_rm_watch( NotifyFd, WatchDescriptor );
+	}
+#endif
+}
+
+FIniFileWatcher::FReloadResult FIniFileWatcher::ReloadFile( const IniFilePtr& File, bool bReportChanges )
+{
+	FReloadResult Result;
+
+	FString FilePath;
+	bool bCompact;
+	bool bLazy;
+	{
+		FReadScopeLock ReadLock( File->GetLock( ) );
+		// a file that matches the document is one this process saved
+		if (File->IsReadOnly( ) || File->IsSameAsFile( ))
+		{
+			return Result;
+		}
+		// the batch may still be rolled back, or committed and saved
+		if (File->IsInBatch( ))
+		{
+			Result.bRetry = true;
+			return Result;
+		}
+		if (File->HasUnsavedChanges( ))
+		{
+			WarnUnsavedChanges( *File );
+			return Result;
+		}
+		FilePath = File->mFilePath;
+		bCompact = File->UsesCompactStorage( );
+		bLazy = File->IsLazy( );
+	}
+
+	double ParseSeconds = 0.0;
+	TSharedPtr<IniRoot> NewRoot = IniFile::ParseFile( FilePath, false, ParseSeconds, bLazy, bCompact );
+	if (!NewRoot)
+	{
+		return Result;
+	}
+
+	FWriteScopeLock WriteLock( File->GetLock( ) );
+	if (File->IsInBatch( ))
+	{
+		Result.bRetry = true;
+	}
+	else if (File->HasUnsavedChanges( ))
+	{
+		WarnUnsavedChanges( *File );
+	}
+	else if (File->mFilePath == FilePath && bReportChanges)
+	{
+		File->ReloadWithChanges( NewRoot, ParseSeconds, Result.Changes );
+	}
+	else if (File->mFilePath == FilePath)
+	{
+		File->AdoptRoot( FilePath, NewRoot, ParseSeconds );
+	}
+	return Result;
+}
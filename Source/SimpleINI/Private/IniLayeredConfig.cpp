@@ -0,0 +1,174 @@
+#include "IniLayeredConfig.h"
+#include "Misc/ScopeRWLock.h"
+#include "IniChangeNotifier.h"
+#include "IniRegistry.h"
+#include "SimpleINIBPLibrary.h"
+
+FIniLayeredConfig::~FIniLayeredConfig( )
+{
+	Reset( );
+}
+
+bool FIniLayeredConfig::Build( const TArray<FString>& FilePaths )
+{
+	Reset( );
+
+	{
+		// set first, so changes broadcast while the layers open below are applied
+		FWriteScopeLock WriteLock( Lock );
+		for (const FString& FilePath : FilePaths)
+		{
+			LayerPaths.Add( FIniRegistry::NormalizePath( FilePath ) );
+		}
+	}
+
+	// Lock is only taken to swap the merged values in: loading a file broadcasts to
+	// HandleValueChanged, which takes Lock itself, and file locks are not taken under it
+	TArray<FDelegateHandle> NewSubscriptions;
+	TMap<TPair<FString, FString>, FMergedValue> NewValues;
+	bool bAllLoaded = true;
+	for (int32 Layer = 0; Layer < FilePaths.Num( ); ++Layer)
+	{
+		const FString& FilePath = FilePaths[Layer];
+
+		// subscribed first, so a file opened below records its changes from the start
+		NewSubscriptions.Add( FIniChangeNotifier::Get( ).SubscribeFile( FilePath,
+			FIniChangeNotifier::FOnValueChanged::FDelegate::CreateRaw( this, &FIniLayeredConfig::HandleValueChanged ) ) );
+
+		IniFilePtr Ini = USimpleINIBPLibrary::FindFileOpened( FilePath );
+		if (!Ini && USimpleINIBPLibrary::LoadIniFile( FilePath ))
+		{
+			Ini = USimpleINIBPLibrary::FindFileOpened( FilePath );
+		}
+		if (!Ini)
+		{
+			bAllLoaded = false;
+			continue;
+		}
+
+		TMap<TPair<FString, FString>, FString> LayerValues;
+		{
+			FWriteScopeLock FileLock( Ini->GetLock( ) );
+			Ini->GetAllValues( LayerValues );
+		}
+		for (TPair<TPair<FString, FString>, FString>& Pair : LayerValues)
+		{
+			FMergedValue& Merged = NewValues.FindOrAdd( Pair.Key );
+			Merged.Value = MoveTemp( Pair.Value );
+			Merged.Layer = Layer;
+		}
+	}
+
+	FWriteScopeLock WriteLock( Lock );
+	Subscriptions = MoveTemp( NewSubscriptions );
+	Values = MoveTemp( NewValues );
+	return bAllLoaded;
+}
+
+bool FIniLayeredConfig::Refresh( )
+{
+	TArray<FString> FilePaths;
+	{
+		FReadScopeLock ReadLock( Lock );
+		FilePaths = LayerPaths;
+	}
+	return Build( FilePaths );
+}
+
+void FIniLayeredConfig::Reset( )
+{
+	for (FDelegateHandle Handle : Subscriptions)
+	{
+		FIniChangeNotifier::Get( ).Unsubscribe( Handle );
+	}
+
+	FWriteScopeLock WriteLock( Lock );
+	Subscriptions.Reset( );
+	LayerPaths.Reset( );
+	Values.Reset( );
+}
+
+bool FIniLayeredConfig::GetValue( const FString& SectionName, const FString& Name, FString& Val, bool& IsValid ) const
+{
+	FReadScopeLock ReadLock( Lock );
+	const FMergedValue* Merged = Values.Find( MakeTuple( SectionName, Name ) );
+	IsValid = (Merged != nullptr);
+	if (Merged)
+	{
+		Val = Merged->Value;
+	}
+	return IsValid;
+}
+
+int32 FIniLayeredConfig::GetValueLayer( const FString& SectionName, const FString& Name ) const
+{
+	FReadScopeLock ReadLock( Lock );
+	const FMergedValue* Merged = Values.Find( MakeTuple( SectionName, Name ) );
+	return Merged ? Merged->Layer : INDEX_NONE;
+}
+
+void FIniLayeredConfig::HandleValueChanged( const FString& FilePath, const IniValueChange& Change )
+{
+	const TPair<FString, FString> Key( Change.SectionName, Change.Name );
+	int32 Layer;
+	TArray<FString> LowerPaths;
+	{
+		FReadScopeLock ReadLock( Lock );
+
+		// a file listed twice counts as its highest layer
+		Layer = LayerPaths.FindLast( FilePath );
+		if (Layer == INDEX_NONE)
+		{
+			return;
+		}
+		const FMergedValue* Merged = Values.Find( Key );
+		if (Merged && Merged->Layer > Layer)
+		{
+			// a higher layer overrides the key either way
+			return;
+		}
+		if (Change.bRemoved)
+		{
+			LowerPaths.Append( LayerPaths.GetData( ), Layer );
+		}
+	}
+
+	FMergedValue NewValue;
+	NewValue.Layer = INDEX_NONE;
+	if (!Change.bRemoved)
+	{
+		NewValue.Value = Change.NewValue;
+		NewValue.Layer = Layer;
+	}
+	else
+	{
+		// the key falls through to the highest layer below that has it; read without
+		// Lock, GetValue takes the file's lock
+		for (int32 Lower = LowerPaths.Num( ) - 1; Lower >= 0; --Lower)
+		{
+			bool IsValid = false;
+			USimpleINIBPLibrary::GetValue( LowerPaths[Lower], Change.SectionName, Change.Name, NewValue.Value, IsValid );
+			if (IsValid)
+			{
+				NewValue.Layer = Lower;
+				break;
+			}
+		}
+	}
+
+	FWriteScopeLock WriteLock( Lock );
+	const FMergedValue* Merged = Values.Find( Key );
+	if (Merged && Merged->Layer > Layer)
+	{
+		// a higher layer set the key in the meantime
+		return;
+	}
+	if (NewValue.Layer == INDEX_NONE)
+	{
+		Values.Remove( Key );
+	}
+	else
+	{
+		Values.Add( Key, MoveTemp( NewValue ) );
+	}
+}
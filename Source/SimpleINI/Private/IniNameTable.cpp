@@ -0,0 +1,140 @@
+#include "IniNameTable.h"
+#include "Misc/ScopeLock.h"
+
+FIniNameTable& FIniNameTable::Get( )
+{
+	static FIniNameTable Table;
+	return Table;
+}
+
+FIniNameTable::FIniNameTable( )
+	: Current( MakeSlotArray( 1024 ) )
+	, NumNames( 0 )
+{
+}
+
+FIniNameTable::~FIniNameTable( )
+{
+	OldArrays.Add( Current.Load( ) );
+	for (FSlotArray* Array : OldArrays)
+	{
+		delete[] Array->Slots;
+		delete Array;
+	}
+	for (FNameRecord* Record : Records)
+	{
+		delete Record;
+	}
+}
+
+FIniNameTable::FSlotArray* FIniNameTable::MakeSlotArray( uint32 NumSlots )
+{
+	FSlotArray* Array = new FSlotArray;
+	Array->Mask = NumSlots - 1;
+	Array->Slots = new TAtomic<FNameRecord*>[NumSlots];
+	for (uint32 i = 0; i < NumSlots; ++i)
+	{
+		Array->Slots[i].Store( nullptr, EMemoryOrder::Relaxed );
+	}
+	return Array;
+}
+
+const FIniNameTable::FNameRecord* FIniNameTable::FindRecord( const FSlotArray& Array, FStringView Name, uint32 Hash )
+{
+	// the array is never full, the probe always reaches an empty slot
+	for (uint32 i = Hash & Array.Mask;; i = (i + 1) & Array.Mask)
+	{
+		const FNameRecord* Record = Array.Slots[i].Load( );
+		if (!Record)
+		{
+			return nullptr;
+		}
+		if (Record->Hash == Hash && Record->Name.Len( ) == Name.Len( ) && FCString::Strnicmp( *Record->Name, Name.GetData( ), Name.Len( ) ) == 0)
+		{
+			return Record;
+		}
+	}
+}
+
+void FIniNameTable::Insert( FSlotArray& Array, FNameRecord* Record )
+{
+	uint32 i = Record->Hash & Array.Mask;
+	while (Array.Slots[i].Load( EMemoryOrder::Relaxed ))
+	{
+		i = (i + 1) & Array.Mask;
+	}
+	Array.Slots[i].Store( Record );
+}
+
+uint32 FIniNameTable::Intern( FStringView Name, uint32 Hash )
+{
+	// nearly every name of a file was seen in an earlier one
+	if (const FNameRecord* Record = FindRecord( *Current.Load( ), Name, Hash ))
+	{
+		return Record->Id;
+	}
+
+	FScopeLock ScopeLock( &Lock );
+	// another thread may have added it in between
+	FSlotArray* Array = Current.Load( );
+	if (const FNameRecord* Record = FindRecord( *Array, Name, Hash ))
+	{
+		return Record->Id;
+	}
+
+	FNameRecord* Record = new FNameRecord;
+	Record->Name = FString( Name );
+	Record->Hash = Hash;
+	Record->Id = (uint32)Records.Add( Record ) + 1;
+
+	// keep at least half of the slots empty so misses stop early
+	if ((uint32)Records.Num( ) * 2 > Array->Mask + 1)
+	{
+		FSlotArray* Grown = MakeSlotArray( (Array->Mask + 1) * 2 );
+		for (FNameRecord* Existing : Records)
+		{
+			Insert( *Grown, Existing );
+		}
+		OldArrays.Add( Array );
+		Current.Store( Grown );
+	}
+	else
+	{
+		Insert( *Array, Record );
+	}
+	NumNames.Store( Records.Num( ) );
+	return Record->Id;
+}
+
+uint32 FIniNameTable::Find( FStringView Name, uint32 Hash ) const
+{
+	const FNameRecord* Record = FindRecord( *Current.Load( ), Name, Hash );
+	return Record ? Record->Id : NoName;
+}
+
+FString FIniNameTable::GetName( uint32 Id ) const
+{
+	FScopeLock ScopeLock( &Lock );
+	return Records.IsValidIndex( (int32)Id - 1 ) ? Records[Id - 1]->Name : FString( );
+}
+
+int32 FIniNameTable::Num( ) const
+{
+	return NumNames.Load( );
+}
+
+SIZE_T FIniNameTable::GetAllocatedSize( ) const
+{
+	FScopeLock ScopeLock( &Lock );
+	SIZE_T Total = Records.GetAllocatedSize( ) + OldArrays.GetAllocatedSize( );
+	for (const FNameRecord* Record : Records)
+	{
+		Total += sizeof( FNameRecord ) + Record->Name.GetAllocatedSize( );
+	}
+	Total += (Current.Load( )->Mask + 1) * sizeof( TAtomic<FNameRecord*> );
+	for (const FSlotArray* Array : OldArrays)
+	{
+		Total += sizeof( FSlotArray ) + (Array->Mask + 1) * sizeof( TAtomic<FNameRecord*> );
+	}
+	return Total;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "Templates/Atomic.h"
+
+// Section and key names of every document in the process, each distinct name (compared
+// case-insensitively, like any name) under one id. Documents keep their own spelling in
+// their text; their records and key handles carry the id, so lookups compare names as
+// integers.
+//
+// Find never locks: names live in an open-addressed slot array that is only ever added
+// to, and a record never changes once its slot points to it. Intern looks the name up
+// the same way and takes the lock only to add a new one. A grown slot array replaces
+// the old one, which is kept because a reader may still be probing it. Ids and their
+// records are never released.
+class FIniNameTable
+{
+public:
+	static FIniNameTable& Get( );
+
+	~FIniNameTable( );
+
+	// Hash is IniRoot::HashName of Name
+	uint32 Intern( FStringView Name, uint32 Hash );
+	// NoName when Name was never interned, so no document has it
+	uint32 Find( FStringView Name, uint32 Hash ) const;
+	// the spelling Name was first interned with
+	FString GetName( uint32 Id ) const;
+
+	int32 Num( ) const;
+	SIZE_T GetAllocatedSize( ) const;
+
+	static const uint32 NoName = 0;
+
+private:
+	FIniNameTable( );
+
+	struct FNameRecord
+	{
+		FString Name;
+		uint32 Hash;
+		uint32 Id;
+	};
+
+	struct FSlotArray
+	{
+		uint32 Mask;
+		TAtomic<FNameRecord*>* Slots;
+	};
+
+	static const FNameRecord* FindRecord( const FSlotArray& Array, FStringView Name, uint32 Hash );
+	static void Insert( FSlotArray& Array, FNameRecord* Record );
+	static FSlotArray* MakeSlotArray( uint32 NumSlots );
+
+	TAtomic<FSlotArray*> Current;
+	TAtomic<int32> NumNames;
+
+	// below only under Lock
+	mutable FCriticalSection Lock;
+	TArray<FNameRecord*> Records;		// by id - 1
+	TArray<FSlotArray*> OldArrays;
+};
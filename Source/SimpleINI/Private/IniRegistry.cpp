@@ -0,0 +1,117 @@
+#include "IniRegistry.h"
+#include "IniNameTable.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeRWLock.h"
+#include "SimpleINI.h"
+
+FIniRegistry& FIniRegistry::Get( )
+{
+	static FIniRegistry Registry;
+	return Registry;
+}
+
+FString FIniRegistry::NormalizePath( const FString& FilePath )
+{
+	FString Path = FilePath;
+	FPaths::NormalizeFilename( Path );
+	if (FPaths::IsRelative( Path ))
+	{
+		Path = FPaths::ConvertRelativePathToFull( Path );
+	}
+	FPaths::CollapseRelativeDirectories( Path );
+	return Path;
+}
+
+IniFilePtr FIniRegistry::Find( const FString& Key ) const
+{
+	const uint32 KeyHash = GetTypeHash( Key );
+	const FShard& Shard = GetShard( KeyHash );
+
+	FReadScopeLock ReadLock( Shard.Lock );
+	const IniFilePtr* File = Shard.Files.FindByHash( KeyHash, Key );
+	return File ? *File : nullptr;
+}
+
+IniFilePtr FIniRegistry::Add( const FString& Key, const IniFilePtr& File )
+{
+	const uint32 KeyHash = GetTypeHash( Key );
+	FShard& Shard = GetShard( KeyHash );
+
+	FWriteScopeLock WriteLock( Shard.Lock );
+	if (const IniFilePtr* Existing = Shard.Files.FindByHash( KeyHash, Key ))
+	{
+		return *Existing;
+	}
+	Shard.Files.AddByHash( KeyHash, Key, File );
+	return File;
+}
+
+void FIniRegistry::Remove( const FString& Key )
+{
+	const uint32 KeyHash = GetTypeHash( Key );
+	FShard& Shard = GetShard( KeyHash );
+
+	FWriteScopeLock WriteLock( Shard.Lock );
+	Shard.Files.RemoveByHash( KeyHash, Key );
+}
+
+void FIniRegistry::GetAll( TArray<TPair<FString, IniFilePtr>>& OutFiles ) const
+{
+	OutFiles.Reset( );
+	for (int i = 0; i < NumShards; ++i)
+	{
+		FReadScopeLock ReadLock( Shards[i].Lock );
+		for (const TPair<FString, IniFilePtr>& File : Shards[i].Files)
+		{
+			OutFiles.Add( File );
+		}
+	}
+}
+
+#if !UE_BUILD_SHIPPING
+
+namespace
+{
+	void DumpStats( )
+	{
+		TArray<TPair<FString, IniFilePtr>> Files;
+		FIniRegistry::Get( ).GetAll( Files );
+		Files.Sort( []( const TPair<FString, IniFilePtr>& A, const TPair<FString, IniFilePtr>& B )
+		{
+			return A.Key < B.Key;
+		} );
+
+		SIZE_T TotalBytes = 0;
+		int64 TotalGrown = 0;
+		for (const TPair<FString, IniFilePtr>& File : Files)
+		{
+			IniFileStats Stats;
+			{
+				FReadScopeLock ReadLock( File.Value->GetLock( ) );
+				Stats = File.Value->GetStats( );
+			}
+			TotalBytes += Stats.AllocatedBytes;
+			TotalGrown += Stats.BytesGrown;
+
+			UE_LOG( LogSimpleINI, Display, TEXT( "%s" ), *File.Key );
+			UE_LOG( LogSimpleINI, Display, TEXT( "    document: %d/%d sections parsed, %d entries, %d chars, %llu bytes, index %d/%d buckets" ),
+				Stats.NumSectionsParsed, Stats.NumSections, Stats.NumEntries, Stats.NumChars, (uint64)Stats.AllocatedBytes,
+				Stats.NumSectionBuckets, Stats.NumNameBuckets );
+			UE_LOG( LogSimpleINI, Display, TEXT( "    %d loads, %lld bytes read, last parse %.3f ms; %d saves, %lld bytes written, last save %.3f ms" ),
+				Stats.NumLoads, Stats.BytesRead, Stats.LastParseSeconds * 1000.0,
+				Stats.NumSaves, Stats.BytesWritten, Stats.LastSaveSeconds * 1000.0 );
+			UE_LOG( LogSimpleINI, Display, TEXT( "    lookups: %lld hits, %lld misses" ), Stats.LookupHits, Stats.LookupMisses );
+			UE_LOG( LogSimpleINI, Display, TEXT( "    grew %d times by %lld bytes" ), Stats.NumGrowths, Stats.BytesGrown );
+		}
+		UE_LOG( LogSimpleINI, Display, TEXT( "%d open files, %llu bytes in documents, %lld bytes grown" ), Files.Num( ), (uint64)TotalBytes, TotalGrown );
+		UE_LOG( LogSimpleINI, Display, TEXT( "name table: %d names, %llu bytes" ), FIniNameTable::Get( ).Num( ), (uint64)FIniNameTable::Get( ).GetAllocatedSize( ) );
+	}
+
+	FAutoConsoleCommand DumpStatsCommand(
+		TEXT( "SimpleINI.DumpStats" ),
+		TEXT( "Logs load, save, lookup and memory statistics of every open ini file." ),
+		FConsoleCommandDelegate::CreateStatic( &DumpStats ) );
+}
+
+#endif
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "ini.h"
+
+// Open files keyed by normalized path. The map is split into shards, each behind
+// its own reader/writer lock, so lookups of different files never contend and
+// lookups of the same file only share a read lock.
+class FIniRegistry
+{
+public:
+	// the registry of the files opened through USimpleINIBPLibrary
+	static FIniRegistry& Get( );
+
+	// absolute path with '/' separators and no relative segments
+	static FString NormalizePath( const FString& FilePath );
+
+	IniFilePtr Find( const FString& Key ) const;
+	// Registers File unless another thread registered Key first; returns whichever is registered.
+	IniFilePtr Add( const FString& Key, const IniFilePtr& File );
+	void Remove( const FString& Key );
+	// copy of every key and file, one shard locked at a time
+	void GetAll( TArray<TPair<FString, IniFilePtr>>& OutFiles ) const;
+
+private:
+	static const int32 NumShards = 16;
+
+	struct FShard
+	{
+		mutable FRWLock Lock;
+		TMap<FString, IniFilePtr> Files;
+	};
+
+	const FShard& GetShard( uint32 KeyHash ) const
+	{
+		return Shards[KeyHash & (NumShards - 1)];
+	}
+	FShard& GetShard( uint32 KeyHash )
+	{
+		return Shards[KeyHash & (NumShards - 1)];
+	}
+
+	FShard Shards[NumShards];
+};
@@ -0,0 +1,411 @@
+#include "IniScanner.h"
+
+#if PLATFORM_CPU_X86_FAMILY
+#include <emmintrin.h>
+#define INI_SCANNER_SSE2 1
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define INI_SCANNER_AVX2 1
+#endif
+#endif
+
+#ifndef INI_SCANNER_SSE2
+#define INI_SCANNER_SSE2 0
+#endif
+#ifndef INI_SCANNER_AVX2
+#define INI_SCANNER_AVX2 0
+#endif
+
+namespace
+{
+	// what is known about the line being scanned, positions are absolute
+	struct FLineState
+	{
+		int32 Start;
+		int32 FirstNonBlank;
+		int32 LastNonBlank;
+		int32 Equal;
+
+		explicit FLineState( int32 InStart )
+			: Start( InStart )
+			, FirstNonBlank( INDEX_NONE )
+			, LastNonBlank( INDEX_NONE )
+			, Equal( INDEX_NONE )
+		{
+		}
+	};
+
+	template <typename UnitType>
+	void EmitLine( const UnitType* Text, int32 LineEnd, FLineState& State, TArray<IniScannedLine>& OutLines )
+	{
+		IniScannedLine& Line = OutLines.AddDefaulted_GetRef( );
+		Line.Start = State.Start;
+		Line.Len = LineEnd - State.Start;
+		if (Line.Len > 0 && Text[LineEnd - 1] == '\r')
+		{
+			--Line.Len;
+		}
+
+		if (State.FirstNonBlank == INDEX_NONE)
+		{
+			Line.TrimStart = 0;
+			Line.TrimEnd = 0;
+			Line.Equal = INDEX_NONE;
+			Line.Kind = EIniLineKind::White;
+		}
+		else
+		{
+			Line.TrimStart = State.FirstNonBlank - State.Start;
+			Line.TrimEnd = State.LastNonBlank + 1 - State.Start;
+			Line.Equal = (State.Equal == INDEX_NONE) ? INDEX_NONE : State.Equal - State.Start;
+
+			const UnitType First = Text[State.FirstNonBlank];
+			if (First == '#'
+				|| (First == '/' && State.FirstNonBlank < State.LastNonBlank && Text[State.FirstNonBlank + 1] == '/'))
+			{
+				Line.Kind = EIniLineKind::Comment;
+			}
+			else if (Line.Equal > Line.TrimStart)
+			{
+				Line.Kind = EIniLineKind::NameValue;
+			}
+			else if (First != '[')
+			{
+				Line.Kind = EIniLineKind::OnlyName;
+			}
+			else
+			{
+				Line.Kind = EIniLineKind::Section;
+			}
+		}
+
+		State = FLineState( LineEnd + 1 );
+	}
+
+	template <typename UnitType>
+	void ScanScalar( const UnitType* Text, int32 From, int32 Len, FLineState& State, TArray<IniScannedLine>& OutLines )
+	{
+		for (int32 i = From; i < Len; ++i)
+		{
+			const UnitType C = Text[i];
+			if (C == '\n')
+			{
+				EmitLine( Text, i, State, OutLines );
+			}
+			else if (!IniScanner::IsWhitespace( C ))
+			{
+				if (State.FirstNonBlank == INDEX_NONE)
+				{
+					State.FirstNonBlank = i;
+				}
+				State.LastNonBlank = i;
+				if (C == '=' && State.Equal == INDEX_NONE)
+				{
+					State.Equal = i;
+				}
+			}
+		}
+	}
+
+	// bit i of each mask describes character Base + i
+	FORCEINLINE void AbsorbMasks( int32 Base, uint32 NonBlank, uint32 Equals, FLineState& State )
+	{
+		if (NonBlank != 0)
+		{
+			if (State.FirstNonBlank == INDEX_NONE)
+			{
+				State.FirstNonBlank = Base + (int32)FMath::CountTrailingZeros( NonBlank );
+			}
+			State.LastNonBlank = Base + 31 - (int32)FMath::CountLeadingZeros( NonBlank );
+		}
+		if (Equals != 0 && State.Equal == INDEX_NONE)
+		{
+			State.Equal = Base + (int32)FMath::CountTrailingZeros( Equals );
+		}
+	}
+
+	template <typename UnitType>
+	FORCEINLINE void ScanMasks( const UnitType* Text, int32 Base, uint32 NewLines, uint32 NonBlank, uint32 Equals, FLineState& State, TArray<IniScannedLine>& OutLines )
+	{
+		while (NewLines != 0)
+		{
+			const uint32 Bit = FMath::CountTrailingZeros( NewLines );
+			const uint32 Below = (1u << Bit) - 1u;
+			AbsorbMasks( Base, NonBlank & Below, Equals & Below, State );
+			EmitLine( Text, Base + (int32)Bit, State, OutLines );
+
+			const uint32 Consumed = Below | (1u << Bit);
+			NonBlank &= ~Consumed;
+			Equals &= ~Consumed;
+			NewLines &= NewLines - 1u;
+		}
+		AbsorbMasks( Base, NonBlank, Equals, State );
+	}
+
+	// Produces the newline, non-blank and '=' masks of one block; Size is 0 when there is no vector path.
+	template <typename UnitType>
+	struct TBlockScanner
+	{
+		static const int32 Size = 0;
+		static void GetMasks( const UnitType* Text, uint32& NewLines, uint32& NonBlank, uint32& Equals ) {}
+	};
+
+#if INI_SCANNER_AVX2
+	template <>
+	struct TBlockScanner<uint8>
+	{
+		static const int32 Size = 32;
+		static FORCEINLINE __m256i IsBlank( __m256i V )
+		{
+			// unsigned (V - 9) < 5 done as a signed compare on biased values
+			const __m256i Control = _mm256_xor_si256( _mm256_sub_epi8( V, _mm256_set1_epi8( 9 ) ), _mm256_set1_epi8( (char)0x80 ) );
+			return _mm256_or_si256( _mm256_cmpeq_epi8( V, _mm256_set1_epi8( ' ' ) ),
+				_mm256_cmpgt_epi8( _mm256_set1_epi8( (char)(0x80 + 5) ), Control ) );
+		}
+		static FORCEINLINE void GetMasks( const uint8* Text, uint32& NewLines, uint32& NonBlank, uint32& Equals )
+		{
+			const __m256i V = _mm256_loadu_si256( (const __m256i*)Text );
+			NewLines = (uint32)_mm256_movemask_epi8( _mm256_cmpeq_epi8( V, _mm256_set1_epi8( '\n' ) ) );
+			Equals = (uint32)_mm256_movemask_epi8( _mm256_cmpeq_epi8( V, _mm256_set1_epi8( '=' ) ) );
+			NonBlank = ~(uint32)_mm256_movemask_epi8( IsBlank( V ) );
+		}
+	};
+
+	template <>
+	struct TBlockScanner<uint16>
+	{
+		static const int32 Size = 32;
+		static FORCEINLINE __m256i IsBlank( __m256i V )
+		{
+			const __m256i Control = _mm256_xor_si256( _mm256_sub_epi16( V, _mm256_set1_epi16( 9 ) ), _mm256_set1_epi16( (short)0x8000 ) );
+			return _mm256_or_si256( _mm256_cmpeq_epi16( V, _mm256_set1_epi16( ' ' ) ),
+				_mm256_cmpgt_epi16( _mm256_set1_epi16( (short)(0x8000 + 5) ), Control ) );
+		}
+		// packs two 16 lane compare results into one 32 bit mask in character order
+		static FORCEINLINE uint32 Pack( __m256i A, __m256i B )
+		{
+			return (uint32)_mm256_movemask_epi8( _mm256_permute4x64_epi64( _mm256_packs_epi16( A, B ), _MM_SHUFFLE( 3, 1, 2, 0 ) ) );
+		}
+		static FORCEINLINE void GetMasks( const uint16* Text, uint32& NewLines, uint32& NonBlank, uint32& Equals )
+		{
+			const __m256i A = _mm256_loadu_si256( (const __m256i*)Text );
+			const __m256i B = _mm256_loadu_si256( (const __m256i*)(Text + 16) );
+			const __m256i NewLine = _mm256_set1_epi16( '\n' );
+			const __m256i Equal = _mm256_set1_epi16( '=' );
+			NewLines = Pack( _mm256_cmpeq_epi16( A, NewLine ), _mm256_cmpeq_epi16( B, NewLine ) );
+			Equals = Pack( _mm256_cmpeq_epi16( A, Equal ), _mm256_cmpeq_epi16( B, Equal ) );
+			NonBlank = ~Pack( IsBlank( A ), IsBlank( B ) );
+		}
+	};
+	template <>
+	struct TBlockScanner<uint32>
+	{
+		static const int32 Size = 32;
+		static FORCEINLINE __m256i IsBlank( __m256i V )
+		{
+			const __m256i Control = _mm256_xor_si256( _mm256_sub_epi32( V, _mm256_set1_epi32( 9 ) ), _mm256_set1_epi32( (int32)0x80000000u ) );
+			return _mm256_or_si256( _mm256_cmpeq_epi32( V, _mm256_set1_epi32( ' ' ) ),
+				_mm256_cmpgt_epi32( _mm256_set1_epi32( (int32)(0x80000000u + 5u) ), Control ) );
+		}
+		// packs four 8 lane compare results into one 32 bit mask in character order; the packs
+		// leave each 128 bit half with 4 characters of every input, the permute restores the order
+		static FORCEINLINE uint32 Pack( __m256i A, __m256i B, __m256i C, __m256i D )
+		{
+			const __m256i Packed = _mm256_packs_epi16( _mm256_packs_epi32( A, B ), _mm256_packs_epi32( C, D ) );
+			return (uint32)_mm256_movemask_epi8( _mm256_permutevar8x32_epi32( Packed, _mm256_setr_epi32( 0, 4, 1, 5, 2, 6, 3, 7 ) ) );
+		}
+		static FORCEINLINE void GetMasks( const uint32* Text, uint32& NewLines, uint32& NonBlank, uint32& Equals )
+		{
+			const __m256i A = _mm256_loadu_si256( (const __m256i*)Text );
+			const __m256i B = _mm256_loadu_si256( (const __m256i*)(Text + 8) );
+			const __m256i C = _mm256_loadu_si256( (const __m256i*)(Text + 16) );
+			const __m256i D = _mm256_loadu_si256( (const __m256i*)(Text + 24) );
+			const __m256i NewLine = _mm256_set1_epi32( '\n' );
+			const __m256i Equal = _mm256_set1_epi32( '=' );
+			NewLines = Pack( _mm256_cmpeq_epi32( A, NewLine ), _mm256_cmpeq_epi32( B, NewLine ), _mm256_cmpeq_epi32( C, NewLine ), _mm256_cmpeq_epi32( D, NewLine ) );
+			Equals = Pack( _mm256_cmpeq_epi32( A, Equal ), _mm256_cmpeq_epi32( B, Equal ), _mm256_cmpeq_epi32( C, Equal ), _mm256_cmpeq_epi32( D, Equal ) );
+			NonBlank = ~Pack( IsBlank( A ), IsBlank( B ), IsBlank( C ), IsBlank( D ) );
+		}
+	};
+#elif INI_SCANNER_SSE2
+	template <>
+	struct TBlockScanner<uint8>
+	{
+		static const int32 Size = 16;
+		static FORCEINLINE __m128i IsBlank( __m128i V )
+		{
+			// unsigned (V - 9) < 5 done as a signed compare on biased values
+			const __m128i Control = _mm_xor_si128( _mm_sub_epi8( V, _mm_set1_epi8( 9 ) ), _mm_set1_epi8( (char)0x80 ) );
+			return _mm_or_si128( _mm_cmpeq_epi8( V, _mm_set1_epi8( ' ' ) ),
+				_mm_cmplt_epi8( Control, _mm_set1_epi8( (char)(0x80 + 5) ) ) );
+		}
+		static FORCEINLINE void GetMasks( const uint8* Text, uint32& NewLines, uint32& NonBlank, uint32& Equals )
+		{
+			const __m128i V = _mm_loadu_si128( (const __m128i*)Text );
+			NewLines = (uint32)_mm_movemask_epi8( _mm_cmpeq_epi8( V, _mm_set1_epi8( '\n' ) ) );
+			Equals = (uint32)_mm_movemask_epi8( _mm_cmpeq_epi8( V, _mm_set1_epi8( '=' ) ) );
+			NonBlank = ~(uint32)_mm_movemask_epi8( IsBlank( V ) ) & 0xFFFFu;
+		}
+	};
+
+	template <>
+	struct TBlockScanner<uint16>
+	{
+		static const int32 Size = 16;
+		static FORCEINLINE __m128i IsBlank( __m128i V )
+		{
+			const __m128i Control = _mm_xor_si128( _mm_sub_epi16( V, _mm_set1_epi16( 9 ) ), _mm_set1_epi16( (short)0x8000 ) );
+			return _mm_or_si128( _mm_cmpeq_epi16( V, _mm_set1_epi16( ' ' ) ),
+				_mm_cmplt_epi16( Control, _mm_set1_epi16( (short)(0x8000 + 5) ) ) );
+		}
+		// packs two 8 lane compare results into one 16 bit mask
+		static FORCEINLINE uint32 Pack( __m128i A, __m128i B )
+		{
+			return (uint32)_mm_movemask_epi8( _mm_packs_epi16( A, B ) );
+		}
+		static FORCEINLINE void GetMasks( const uint16* Text, uint32& NewLines, uint32& NonBlank, uint32& Equals )
+		{
+			const __m128i A = _mm_loadu_si128( (const __m128i*)Text );
+			const __m128i B = _mm_loadu_si128( (const __m128i*)(Text + 8) );
+			const __m128i NewLine = _mm_set1_epi16( '\n' );
+			const __m128i Equal = _mm_set1_epi16( '=' );
+			NewLines = Pack( _mm_cmpeq_epi16( A, NewLine ), _mm_cmpeq_epi16( B, NewLine ) );
+			Equals = Pack( _mm_cmpeq_epi16( A, Equal ), _mm_cmpeq_epi16( B, Equal ) );
+			NonBlank = ~Pack( IsBlank( A ), IsBlank( B ) ) & 0xFFFFu;
+		}
+	};
+	template <>
+	struct TBlockScanner<uint32>
+	{
+		static const int32 Size = 16;
+		static FORCEINLINE __m128i IsBlank( __m128i V )
+		{
+			const __m128i Control = _mm_xor_si128( _mm_sub_epi32( V, _mm_set1_epi32( 9 ) ), _mm_set1_epi32( (int32)0x80000000u ) );
+			return _mm_or_si128( _mm_cmpeq_epi32( V, _mm_set1_epi32( ' ' ) ),
+				_mm_cmplt_epi32( Control, _mm_set1_epi32( (int32)(0x80000000u + 5u) ) ) );
+		}
+		// packs four 4 lane compare results into one 16 bit mask
+		static FORCEINLINE uint32 Pack( __m128i A, __m128i B, __m128i C, __m128i D )
+		{
+			return (uint32)_mm_movemask_epi8( _mm_packs_epi16( _mm_packs_epi32( A, B ), _mm_packs_epi32( C, D ) ) );
+		}
+		static FORCEINLINE void GetMasks( const uint32* Text, uint32& NewLines, uint32& NonBlank, uint32& Equals )
+		{
+			const __m128i A = _mm_loadu_si128( (const __m128i*)Text );
+			const __m128i B = _mm_loadu_si128( (const __m128i*)(Text + 4) );
+			const __m128i C = _mm_loadu_si128( (const __m128i*)(Text + 8) );
+			const __m128i D = _mm_loadu_si128( (const __m128i*)(Text + 12) );
+			const __m128i NewLine = _mm_set1_epi32( '\n' );
+			const __m128i Equal = _mm_set1_epi32( '=' );
+			NewLines = Pack( _mm_cmpeq_epi32( A, NewLine ), _mm_cmpeq_epi32( B, NewLine ), _mm_cmpeq_epi32( C, NewLine ), _mm_cmpeq_epi32( D, NewLine ) );
+			Equals = Pack( _mm_cmpeq_epi32( A, Equal ), _mm_cmpeq_epi32( B, Equal ), _mm_cmpeq_epi32( C, Equal ), _mm_cmpeq_epi32( D, Equal ) );
+			NonBlank = ~Pack( IsBlank( A ), IsBlank( B ), IsBlank( C ), IsBlank( D ) ) & 0xFFFFu;
+		}
+	};
+#endif
+
+	template <typename UnitType>
+	void ScanAll( const UnitType* Text, int32 Len, TArray<IniScannedLine>& OutLines )
+	{
+		typedef TBlockScanner<UnitType> FBlockScanner;
+
+		FLineState State( 0 );
+		int32 Pos = 0;
+		if (FBlockScanner::Size > 0)
+		{
+			for (; Pos + FBlockScanner::Size <= Len; Pos += FBlockScanner::Size)
+			{
+				uint32 NewLines, NonBlank, Equals;
+				FBlockScanner::GetMasks( Text + Pos, NewLines, NonBlank, Equals );
+				ScanMasks( Text, Pos, NewLines, NonBlank, Equals, State, OutLines );
+			}
+		}
+		ScanScalar( Text, Pos, Len, State, OutLines );
+
+		if (State.Start < Len)
+		{
+			// last line has no terminator
+			EmitLine( Text, Len, State, OutLines );
+		}
+	}
+
+	template <typename UnitType>
+	void ScanSectionsChunked( const UnitType* Text, int32 Len, TArray<IniScannedLine>& OutHeaders )
+	{
+		const int32 ChunkSize = 1 << 20;
+
+		TArray<IniScannedLine> Lines;
+		for (int32 ChunkStart = 0; ChunkStart < Len; )
+		{
+			int32 ChunkEnd = FMath::Min( Len, ChunkStart + ChunkSize );
+			if (ChunkEnd < Len)
+			{
+				// end the chunk behind a line terminator, past it if a line is longer than a chunk
+				int32 Cut = ChunkEnd;
+				while (Cut > ChunkStart && Text[Cut - 1] != '\n')
+				{
+					--Cut;
+				}
+				if (Cut == ChunkStart)
+				{
+					Cut = ChunkEnd;
+					while (Cut < Len && Text[Cut++] != '\n')
+					{
+					}
+				}
+				ChunkEnd = Cut;
+			}
+
+			Lines.Reset( );
+			ScanAll( Text + ChunkStart, ChunkEnd - ChunkStart, Lines );
+			for (int i = 0; i < Lines.Num( ); ++i)
+			{
+				if (Lines[i].Kind == EIniLineKind::Section)
+				{
+					IniScannedLine& Header = OutHeaders.Add_GetRef( Lines[i] );
+					Header.Start += ChunkStart;
+				}
+			}
+			ChunkStart = ChunkEnd;
+		}
+	}
+}
+
+const TCHAR* IniScanner::GetPathName( )
+{
+	typedef TChooseClass<sizeof( TCHAR ) == 2, uint16, uint32>::Result UnitType;
+
+	if (TBlockScanner<UnitType>::Size == 0)
+	{
+		return TEXT( "scalar" );
+	}
+	return INI_SCANNER_AVX2 ? TEXT( "AVX2" ) : TEXT( "SSE2" );
+}
+
+void IniScanner::ScanLines( const TCHAR* Text, int32 Len, TArray<IniScannedLine>& OutLines )
+{
+	typedef TChooseClass<sizeof( TCHAR ) == 2, uint16, uint32>::Result UnitType;
+
+	OutLines.Reset( );
+	ScanAll( reinterpret_cast<const UnitType*>( Text ), Len, OutLines );
+}
+
+void IniScanner::ScanLines( const ANSICHAR* Text, int32 Len, TArray<IniScannedLine>& OutLines )
+{
+	OutLines.Reset( );
+	ScanAll( reinterpret_cast<const uint8*>( Text ), Len, OutLines );
+}
+
+void IniScanner::ScanSections( const TCHAR* Text, int32 Len, TArray<IniScannedLine>& OutHeaders )
+{
+	typedef TChooseClass<sizeof( TCHAR ) == 2, uint16, uint32>::Result UnitType;
+
+	OutHeaders.Reset( );
+	ScanSectionsChunked( reinterpret_cast<const UnitType*>( Text ), Len, OutHeaders );
+}
+
+void IniScanner::ScanSections( const ANSICHAR* Text, int32 Len, TArray<IniScannedLine>& OutHeaders )
+{
+	OutHeaders.Reset( );
+	ScanSectionsChunked( reinterpret_cast<const uint8*>( Text ), Len, OutHeaders );
+}
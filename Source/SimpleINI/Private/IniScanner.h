@@ -0,0 +1,60 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+enum class EIniLineKind : uint8
+{
+	White,
+	Comment,		// first non-blank characters are # or //
+	NameValue,		// has a '=' after its first non-blank character
+	OnlyName,
+	Section,		// first non-blank character is [
+};
+
+// One row of the line table IniScanner produces; offsets other than Start are relative to Start.
+struct IniScannedLine
+{
+	int32 Start;
+	int32 Len;			// without the line terminator
+	int32 TrimStart;	// first non-blank character
+	int32 TrimEnd;		// one past the last non-blank character
+	int32 Equal;		// first '=', INDEX_NONE if the line has none
+	EIniLineKind Kind;
+};
+
+namespace IniScanner
+{
+	// space, \t, \n, \v, \f and \r: the set the vector path tests for
+	FORCEINLINE bool IsWhitespace( uint32 C )
+	{
+		return C == ' ' || (C - 9u) < 5u;
+	}
+
+	// narrows [Start, End) to its non-blank characters
+	template <typename CharType>
+	FORCEINLINE void TrimRange( const CharType* Str, int32& Start, int32& End )
+	{
+		while (Start < End && IsWhitespace( (uint32)Str[Start] ))
+		{
+			++Start;
+		}
+		while (End > Start && IsWhitespace( (uint32)Str[End - 1] ))
+		{
+			--End;
+		}
+	}
+
+	// Splits Text into lines and classifies every line in a single pass over the characters.
+	// Uses AVX2 when the module is compiled for it, SSE2 on other x86 targets and plain C++ elsewhere.
+	void ScanLines( const TCHAR* Text, int32 Len, TArray<IniScannedLine>& OutLines );
+	// Same for UTF-8 text; multi-byte sequences never contain any of the bytes the scanner looks for.
+	void ScanLines( const ANSICHAR* Text, int32 Len, TArray<IniScannedLine>& OutLines );
+
+	// Only the Section lines, scanned a chunk at a time so the line table never has to
+	// hold every line of a large file.
+	void ScanSections( const TCHAR* Text, int32 Len, TArray<IniScannedLine>& OutHeaders );
+	void ScanSections( const ANSICHAR* Text, int32 Len, TArray<IniScannedLine>& OutHeaders );
+
+	// the path ScanLines and ScanSections take for TCHAR text: "AVX2", "SSE2" or "scalar"
+	const TCHAR* GetPathName( );
+}
@@ -0,0 +1,179 @@
+#include "IniStreamReader.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Templates/UniquePtr.h"
+#include "IniScanner.h"
+#include "SimpleINIStats.h"
+
+namespace
+{
+	// characters of a text buffer scanned at a time
+	const int32 TextChunkChars = 64 * 1024;
+
+	bool VisitLine( const TCHAR* Text, const IniScannedLine& Line, IniVisitor& Visitor )
+	{
+		// same trimming as IniRoot::ParseLine and IniRoot::InitEntry
+		const TCHAR* LineText = Text + Line.Start;
+		switch (Line.Kind)
+		{
+		case EIniLineKind::Section:
+			{
+				int32 NameStart = Line.TrimStart + 1;
+				int32 NameEnd = FMath::Max( NameStart, Line.TrimEnd - 1 );
+				IniScanner::TrimRange( LineText, NameStart, NameEnd );
+				return Visitor.OnSection( FStringView( LineText + NameStart, NameEnd - NameStart ) );
+			}
+		case EIniLineKind::Comment:
+			{
+				int32 TextStart = Line.TrimStart + (LineText[Line.TrimStart] == TEXT( '#' ) ? 1 : 2);
+				int32 TextEnd = Line.TrimEnd;
+				IniScanner::TrimRange( LineText, TextStart, TextEnd );
+				return Visitor.OnComment( FStringView( LineText + TextStart, TextEnd - TextStart ) );
+			}
+		case EIniLineKind::NameValue:
+			{
+				int32 NameStart = Line.TrimStart;
+				int32 NameEnd = Line.Equal;
+				IniScanner::TrimRange( LineText, NameStart, NameEnd );
+				int32 ValueStart = Line.Equal + 1;
+				int32 ValueEnd = Line.TrimEnd;
+				IniScanner::TrimRange( LineText, ValueStart, ValueEnd );
+				return Visitor.OnKeyValue( FStringView( LineText + NameStart, NameEnd - NameStart ), FStringView( LineText + ValueStart, ValueEnd - ValueStart ) );
+			}
+		case EIniLineKind::OnlyName:
+			return Visitor.OnName( FStringView( LineText + Line.TrimStart, Line.TrimEnd - Line.TrimStart ) );
+		default:
+			return Visitor.OnBlank( );
+		}
+	}
+
+	// false when the visitor stopped
+	bool VisitLines( const TCHAR* Text, int32 Len, IniVisitor& Visitor, TArray<IniScannedLine>& Lines )
+	{
+		IniScanner::ScanLines( Text, Len, Lines );
+		INC_DWORD_STAT_BY( STAT_IniLinesParsed, Lines.Num( ) );
+		for (int i = 0; i < Lines.Num( ); ++i)
+		{
+			if (!VisitLine( Text, Lines[i], Visitor ))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+EIniVisitResult IniStreamReader::VisitFile( const FString& FilePath, IniVisitor& Visitor, int32 ChunkBytes /*= 64 * 1024*/ )
+{
+	SCOPE_CYCLE_COUNTER( STAT_IniLoad );
+	SCOPED_NAMED_EVENT_FSTRING( FilePath, FColor::Turquoise );
+
+	TUniquePtr<FArchive> Reader( IFileManager::Get( ).CreateFileReader( *FilePath ) );
+	if (!Reader)
+	{
+		return EIniVisitResult::Failed;
+	}
+
+	TArray<uint8> Bytes;
+	Bytes.SetNumUninitialized( FMath::Max( ChunkBytes, 16 ) );
+	TArray<IniScannedLine> Lines;
+	int64 Remaining = Reader->TotalSize( );
+	int32 Carry = 0;
+	bool bFirstChunk = true;
+	while (Remaining > 0)
+	{
+		if (Carry == Bytes.Num( ))
+		{
+			// no line terminator in the whole buffer
+			Bytes.SetNumUninitialized( Bytes.Num( ) * 2 );
+		}
+		const int32 ToRead = (int32)FMath::Min<int64>( Remaining, Bytes.Num( ) - Carry );
+		Reader->Serialize( Bytes.GetData( ) + Carry, ToRead );
+		if (Reader->IsError( ))
+		{
+			return EIniVisitResult::Failed;
+		}
+		Remaining -= ToRead;
+		INC_DWORD_STAT_BY( STAT_IniBytesRead, ToRead );
+		int32 Len = Carry + ToRead;
+
+		if (bFirstChunk)
+		{
+			bFirstChunk = false;
+			if (Len >= 2 && ((Bytes[0] == 0xFF && Bytes[1] == 0xFE) || (Bytes[0] == 0xFE && Bytes[1] == 0xFF)))
+			{
+				// UTF-16 is converted whole, the way IniFile::ParseBytes does it
+				Reader.Reset( );
+				FString Text;
+				if (!FFileHelper::LoadFileToString( Text, *FilePath ))
+				{
+					return EIniVisitResult::Failed;
+				}
+				return VisitText( Text, Visitor );
+			}
+			if (Len >= 3 && Bytes[0] == 0xEF && Bytes[1] == 0xBB && Bytes[2] == 0xBF)
+			{
+				Len -= 3;
+				FMemory::Memmove( Bytes.GetData( ), Bytes.GetData( ) + 3, Len );
+			}
+		}
+
+		// only whole lines are converted, the rest waits for the next read; a line
+		// terminator never sits inside a multi-byte sequence
+		int32 End = Len;
+		if (Remaining > 0)
+		{
+			while (End > 0 && Bytes[End - 1] != '\n')
+			{
+				--End;
+			}
+		}
+		if (End > 0)
+		{
+			const FUTF8ToTCHAR Converted( (const ANSICHAR*)Bytes.GetData( ), End );
+			if (!VisitLines( Converted.Get( ), Converted.Length( ), Visitor, Lines ))
+			{
+				return EIniVisitResult::Stopped;
+			}
+		}
+		Carry = Len - End;
+		FMemory::Memmove( Bytes.GetData( ), Bytes.GetData( ) + End, Carry );
+	}
+	return EIniVisitResult::Completed;
+}
+
+EIniVisitResult IniStreamReader::VisitText( FStringView Text, IniVisitor& Visitor )
+{
+	const TCHAR* Data = Text.GetData( );
+	const int32 Len = Text.Len( );
+
+	TArray<IniScannedLine> Lines;
+	for (int32 ChunkStart = 0; ChunkStart < Len; )
+	{
+		int32 ChunkEnd = FMath::Min( Len, ChunkStart + TextChunkChars );
+		if (ChunkEnd < Len)
+		{
+			// end the chunk behind a line terminator, past it if a line is longer than a chunk
+			int32 Cut = ChunkEnd;
+			while (Cut > ChunkStart && Data[Cut - 1] != '\n')
+			{
+				--Cut;
+			}
+			if (Cut == ChunkStart)
+			{
+				Cut = ChunkEnd;
+				while (Cut < Len && Data[Cut++] != '\n')
+				{
+				}
+			}
+			ChunkEnd = Cut;
+		}
+
+		if (!VisitLines( Data + ChunkStart, ChunkEnd - ChunkStart, Visitor, Lines ))
+		{
+			return EIniVisitResult::Stopped;
+		}
+		ChunkStart = ChunkEnd;
+	}
+	return EIniVisitResult::Completed;
+}
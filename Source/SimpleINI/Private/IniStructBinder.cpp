@@ -0,0 +1,399 @@
+#include "IniStructBinder.h"
+#include "UObject/UnrealType.h"
+#include "UObject/EnumProperty.h"
+#include "UObject/TextProperty.h"
+#include "UObject/ObjectKey.h"
+#include "Misc/OutputDeviceNull.h"
+#include "Misc/ScopeRWLock.h"
+
+namespace
+{
+	// binders by struct; a key never matches a struct that replaced a collected one, and
+	// the binders of collected structs are removed by the next Get that adds one
+	FRWLock BindersLock;
+	TMap<FObjectKey, TUniquePtr<FIniStructBinder>> Binders;
+
+	// Text conversion of one property class. Anything without a specialization uses the
+	// property's own text format: "(X=1,Y=2,Z=3)" for structs, "(A,B)" for arrays.
+	template <typename PropertyType>
+	struct TIniPropertyConverter
+	{
+		static bool Import( const FProperty* Property, void* Value, const FString& Text )
+		{
+			FOutputDeviceNull Errors;
+			return Property->ImportText( *Text, Value, PPF_None, nullptr, &Errors ) != nullptr;
+		}
+		static void Export( const FProperty* Property, const void* Value, FString& OutText )
+		{
+			Property->ExportTextItem( OutText, Value, nullptr, nullptr, PPF_None );
+		}
+	};
+
+	template <>
+	struct TIniPropertyConverter<FBoolProperty>
+	{
+		// same spellings as IniFile::GetBool
+		static bool Import( const FProperty* Property, void* Value, const FString& Text )
+		{
+			bool bValue;
+			if (!IniTypedValue::ParseBool( Text, bValue ))
+			{
+				return false;
+			}
+			CastFieldChecked<FBoolProperty>( Property )->SetPropertyValue( Value, bValue );
+			return true;
+		}
+		static void Export( const FProperty* Property, const void* Value, FString& OutText )
+		{
+			OutText = LexToString( CastFieldChecked<FBoolProperty>( Property )->GetPropertyValue( Value ) );
+		}
+	};
+
+	// integers of any size and sign
+	template <>
+	struct TIniPropertyConverter<FNumericProperty>
+	{
+		static bool Import( const FProperty* Property, void* Value, const FString& Text )
+		{
+			int64 Number;
+			if (!LexTryParseString( Number, *Text ))
+			{
+				return false;
+			}
+			CastFieldChecked<FNumericProperty>( Property )->SetIntPropertyValue( Value, Number );
+			return true;
+		}
+		static void Export( const FProperty* Property, const void* Value, FString& OutText )
+		{
+			OutText = CastFieldChecked<FNumericProperty>( Property )->GetNumericPropertyValueToString( Value );
+		}
+	};
+
+	template <typename FloatPropertyType>
+	struct TIniFloatConverter
+	{
+		static bool Import( const FProperty* Property, void* Value, const FString& Text )
+		{
+			typename FloatPropertyType::TCppType Number;
+			if (!LexTryParseString( Number, *Text ))
+			{
+				return false;
+			}
+			CastFieldChecked<FloatPropertyType>( Property )->SetPropertyValue( Value, Number );
+			return true;
+		}
+		// "0.5" rather than "0.500000"
+		static void Export( const FProperty* Property, const void* Value, FString& OutText )
+		{
+			OutText = LexToSanitizedString( CastFieldChecked<FloatPropertyType>( Property )->GetPropertyValue( Value ) );
+		}
+	};
+
+	template <>
+	struct TIniPropertyConverter<FFloatProperty> : TIniFloatConverter<FFloatProperty>
+	{
+	};
+
+	template <>
+	struct TIniPropertyConverter<FDoubleProperty> : TIniFloatConverter<FDoubleProperty>
+	{
+	};
+
+	// enumerators by name, with or without the enum prefix, or by value
+	bool ImportEnum( const UEnum* Enum, const FNumericProperty* Underlying, void* Value, const FString& Text )
+	{
+		int64 Number = Enum->GetValueByNameString( Text );
+		if (Number == INDEX_NONE && !LexTryParseString( Number, *Text ))
+		{
+			return false;
+		}
+		Underlying->SetIntPropertyValue( Value, Number );
+		return true;
+	}
+
+	void ExportEnum( const UEnum* Enum, const FNumericProperty* Underlying, const void* Value, FString& OutText )
+	{
+		const int64 Number = Underlying->GetSignedIntPropertyValue( Value );
+		OutText = Enum->GetNameStringByValue( Number );
+		if (OutText.IsEmpty( ))
+		{
+			OutText = LexToString( Number );
+		}
+	}
+
+	template <>
+	struct TIniPropertyConverter<FEnumProperty>
+	{
+		static bool Import( const FProperty* Property, void* Value, const FString& Text )
+		{
+			const FEnumProperty* EnumProperty = CastFieldChecked<FEnumProperty>( Property );
+			return ImportEnum( EnumProperty->GetEnum( ), EnumProperty->GetUnderlyingProperty( ), Value, Text );
+		}
+		static void Export( const FProperty* Property, const void* Value, FString& OutText )
+		{
+			const FEnumProperty* EnumProperty = CastFieldChecked<FEnumProperty>( Property );
+			ExportEnum( EnumProperty->GetEnum( ), EnumProperty->GetUnderlyingProperty( ), Value, OutText );
+		}
+	};
+
+	// only picked for TEnumAsByte, plain bytes are integers
+	template <>
+	struct TIniPropertyConverter<FByteProperty>
+	{
+		static bool Import( const FProperty* Property, void* Value, const FString& Text )
+		{
+			const FByteProperty* ByteProperty = CastFieldChecked<FByteProperty>( Property );
+			return ImportEnum( ByteProperty->Enum, ByteProperty, Value, Text );
+		}
+		static void Export( const FProperty* Property, const void* Value, FString& OutText )
+		{
+			const FByteProperty* ByteProperty = CastFieldChecked<FByteProperty>( Property );
+			ExportEnum( ByteProperty->Enum, ByteProperty, Value, OutText );
+		}
+	};
+
+	template <>
+	struct TIniPropertyConverter<FStrProperty>
+	{
+		static bool Import( const FProperty* Property, void* Value, const FString& Text )
+		{
+			CastFieldChecked<FStrProperty>( Property )->SetPropertyValue( Value, Text );
+			return true;
+		}
+		static void Export( const FProperty* Property, const void* Value, FString& OutText )
+		{
+			OutText = CastFieldChecked<FStrProperty>( Property )->GetPropertyValue( Value );
+		}
+	};
+
+	template <>
+	struct TIniPropertyConverter<FNameProperty>
+	{
+		static bool Import( const FProperty* Property, void* Value, const FString& Text )
+		{
+			CastFieldChecked<FNameProperty>( Property )->SetPropertyValue( Value, FName( *Text ) );
+			return true;
+		}
+		static void Export( const FProperty* Property, const void* Value, FString& OutText )
+		{
+			OutText = CastFieldChecked<FNameProperty>( Property )->GetPropertyValue( Value ).ToString( );
+		}
+	};
+
+	// the text is taken as it is, not as a localized text literal
+	template <>
+	struct TIniPropertyConverter<FTextProperty>
+	{
+		static bool Import( const FProperty* Property, void* Value, const FString& Text )
+		{
+			CastFieldChecked<FTextProperty>( Property )->SetPropertyValue( Value, FText::FromString( Text ) );
+			return true;
+		}
+		static void Export( const FProperty* Property, const void* Value, FString& OutText )
+		{
+			OutText = CastFieldChecked<FTextProperty>( Property )->GetPropertyValue( Value ).ToString( );
+		}
+	};
+}
+
+FIniStructBinder::FIniStructBinder( const UStruct* InStruct )
+	: Struct( InStruct )
+{
+	for (TFieldIterator<FProperty> It( Struct ); It; ++It)
+	{
+		const FProperty* Property = *It;
+		if (Property->ArrayDim != 1 || Property->HasAnyPropertyFlags( CPF_Transient | CPF_Deprecated ))
+		{
+			continue;
+		}
+		FBinding& Binding = Bindings.AddDefaulted_GetRef( );
+		Binding.Property = Property;
+		// Blueprint structs decorate the property names, the authored name is what users see
+		Binding.Name = Property->GetAuthoredName( );
+		Binding.NameHash = IniRoot::HashName( *Binding.Name, Binding.Name.Len( ) );
+		Binding.NameId = IniRoot::InternName( *Binding.Name, Binding.Name.Len( ), Binding.NameHash );
+		const FTCHARToUTF8 Utf8Name( *Binding.Name, Binding.Name.Len( ) );
+		Binding.Utf8Name.Append( Utf8Name.Get( ), Utf8Name.Length( ) );
+		Binding.Utf8NameHash = IniRoot::HashName( Utf8Name.Get( ), Utf8Name.Length( ) );
+		SelectConverter( Property, Binding );
+	}
+
+	Buckets.Init( INDEX_NONE, (int32)FMath::RoundUpToPowerOfTwo( (uint32)FMath::Max( Bindings.Num( ) * 2, 16 ) ) );
+	Utf8Buckets.Init( INDEX_NONE, Buckets.Num( ) );
+	for (int32 i = 0; i < Bindings.Num( ); ++i)
+	{
+		int32& Bucket = Buckets[Bindings[i].NameHash & (Buckets.Num( ) - 1)];
+		Bindings[i].HashNext = Bucket;
+		Bucket = i;
+
+		int32& Utf8Bucket = Utf8Buckets[Bindings[i].Utf8NameHash & (Utf8Buckets.Num( ) - 1)];
+		Bindings[i].Utf8HashNext = Utf8Bucket;
+		Utf8Bucket = i;
+	}
+}
+
+const FIniStructBinder& FIniStructBinder::Get( const UStruct* Struct )
+{
+	check( Struct );
+	const FObjectKey Key( Struct );
+	{
+		FReadScopeLock ReadLock( BindersLock );
+		if (const TUniquePtr<FIniStructBinder>* Found = Binders.Find( Key ))
+		{
+			return **Found;
+		}
+	}
+
+	FWriteScopeLock WriteLock( BindersLock );
+	// binders of collected structs hold dangling property pointers, drop them while
+	// adding; nobody can be using one, its struct is gone
+	for (auto It = Binders.CreateIterator( ); It; ++It)
+	{
+		if (!It.Key( ).ResolveObjectPtr( ))
+		{
+			It.RemoveCurrent( );
+		}
+	}
+	TUniquePtr<FIniStructBinder>& Binder = Binders.FindOrAdd( Key );
+	if (!Binder)
+	{
+		Binder = MakeUnique<FIniStructBinder>( Struct );
+	}
+	return *Binder;
+}
+
+void FIniStructBinder::SelectConverter( const FProperty* Property, FBinding& Binding )
+{
+	const FNumericProperty* Numeric = CastField<FNumericProperty>( Property );
+	const FByteProperty* Byte = CastField<FByteProperty>( Property );
+
+#define SIMPLEINI_SELECT_CONVERTER( PropertyType ) \
+	Binding.Import = &TIniPropertyConverter<PropertyType>::Import; \
+	Binding.Export = &TIniPropertyConverter<PropertyType>::Export
+
+	if (Property->IsA<FBoolProperty>( ))
+	{
+		SIMPLEINI_SELECT_CONVERTER( FBoolProperty );
+	}
+	else if (Property->IsA<FEnumProperty>( ))
+	{
+		SIMPLEINI_SELECT_CONVERTER( FEnumProperty );
+	}
+	else if (Byte && Byte->Enum)
+	{
+		SIMPLEINI_SELECT_CONVERTER( FByteProperty );
+	}
+	else if (Property->IsA<FFloatProperty>( ))
+	{
+		SIMPLEINI_SELECT_CONVERTER( FFloatProperty );
+	}
+	else if (Property->IsA<FDoubleProperty>( ))
+	{
+		SIMPLEINI_SELECT_CONVERTER( FDoubleProperty );
+	}
+	else if (Numeric && Numeric->IsInteger( ))
+	{
+		SIMPLEINI_SELECT_CONVERTER( FNumericProperty );
+	}
+	else if (Property->IsA<FStrProperty>( ))
+	{
+		SIMPLEINI_SELECT_CONVERTER( FStrProperty );
+	}
+	else if (Property->IsA<FNameProperty>( ))
+	{
+		SIMPLEINI_SELECT_CONVERTER( FNameProperty );
+	}
+	else if (Property->IsA<FTextProperty>( ))
+	{
+		SIMPLEINI_SELECT_CONVERTER( FTextProperty );
+	}
+	else
+	{
+		SIMPLEINI_SELECT_CONVERTER( FProperty );
+	}
+
+#undef SIMPLEINI_SELECT_CONVERTER
+}
+
+void FIniStructBinder::FindEntries( const IniRoot& Root, int32 SectionIndex, TArray<int32>& OutEntries ) const
+{
+	OutEntries.Init( INDEX_NONE, Bindings.Num( ) );
+
+	// compact documents do not intern their names, their entries are compared by text
+	const bool bUtf8 = Root.IsUtf8( );
+	const IniSection& Section = Root.Sections[SectionIndex];
+	for (int32 EntryIndex = Section.FirstEntry; EntryIndex != INDEX_NONE; EntryIndex = Root.Entries[EntryIndex].Next)
+	{
+		// a name without value shadows earlier values too, as it does for FindEntry
+		const IniSectionContentEntry& Entry = Root.Entries[EntryIndex];
+		if (Entry.SubType != eNameValuePair && Entry.SubType != eOnlyName)
+		{
+			continue;
+		}
+
+		if (bUtf8)
+		{
+			// names compare the way FindEntry compares them in a compact document
+			const ANSICHAR* Name = Root.GetUtf8Chars( Entry.Name );
+			for (int32 i = Utf8Buckets[Entry.NameHash & (Utf8Buckets.Num( ) - 1)]; i != INDEX_NONE; i = Bindings[i].Utf8HashNext)
+			{
+				const FBinding& Binding = Bindings[i];
+				if (Binding.Utf8NameHash == Entry.NameHash && Binding.Utf8Name.Num( ) == Entry.Name.Len
+					&& FCStringAnsi::Strnicmp( Name, Binding.Utf8Name.GetData( ), Entry.Name.Len ) == 0)
+				{
+					OutEntries[i] = EntryIndex;
+				}
+			}
+			continue;
+		}
+
+		for (int32 i = Buckets[Entry.NameHash & (Buckets.Num( ) - 1)]; i != INDEX_NONE; i = Bindings[i].HashNext)
+		{
+			const FBinding& Binding = Bindings[i];
+			if (Binding.NameId == Entry.NameId)
+			{
+				OutEntries[i] = EntryIndex;
+			}
+		}
+	}
+}
+
+int32 FIniStructBinder::Import( const IniRoot& Root, int32 SectionIndex, void* Data ) const
+{
+	TArray<int32> EntryIndices;
+	FindEntries( Root, SectionIndex, EntryIndices );
+
+	int32 NumSet = 0;
+	FString Scratch;
+	FString Text;
+	for (int32 i = 0; i < Bindings.Num( ); ++i)
+	{
+		const int32 EntryIndex = EntryIndices[i];
+		if (EntryIndex == INDEX_NONE || Root.Entries[EntryIndex].SubType != eNameValuePair)
+		{
+			continue;
+		}
+		// the converters want a terminated string, reuse one buffer for all of them
+		const FStringView Value = Root.GetString( Root.Entries[EntryIndex].Value, Scratch );
+		Text.Reset( );
+		Text.Append( Value.GetData( ), Value.Len( ) );
+
+		const FBinding& Binding = Bindings[i];
+		if (Binding.Import( Binding.Property, Binding.Property->ContainerPtrToValuePtr<void>( Data ), Text ))
+		{
+			++NumSet;
+		}
+	}
+	return NumSet;
+}
+
+void FIniStructBinder::Export( const void* Data, TArray<TPair<FString, FString>>& OutValues ) const
+{
+	OutValues.Reset( Bindings.Num( ) );
+	for (const FBinding& Binding : Bindings)
+	{
+		TPair<FString, FString>& Value = OutValues.AddDefaulted_GetRef( );
+		Value.Key = Binding.Name;
+		Binding.Export( Binding.Property, Binding.Property->ContainerPtrToValuePtr<void>( Data ), Value.Value );
+	}
+}
@@ -1,9 +1,28 @@
 // Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
 
 #include "SimpleINI.h"
+#include "IniFileWatcher.h"
+#include "SimpleINIStats.h"
 
 #define LOCTEXT_NAMESPACE "FSimpleINIModule"
 
+DEFINE_LOG_CATEGORY( LogSimpleINI );
+
+DEFINE_STAT( STAT_IniLoad );
+DEFINE_STAT( STAT_IniParse );
+DEFINE_STAT( STAT_IniParseSection );
+DEFINE_STAT( STAT_IniBuildIndex );
+DEFINE_STAT( STAT_IniSave );
+DEFINE_STAT( STAT_IniBytesRead );
+DEFINE_STAT( STAT_IniBytesWritten );
+DEFINE_STAT( STAT_IniLinesParsed );
+DEFINE_STAT( STAT_IniIndexBuckets );
+DEFINE_STAT( STAT_IniLookupHits );
+DEFINE_STAT( STAT_IniLookupMisses );
+DEFINE_STAT( STAT_IniDocumentMemory );
+DEFINE_STAT( STAT_IniDocumentGrowths );
+DEFINE_STAT( STAT_IniDocumentBytesGrown );
+
 void FSimpleINIModule::StartupModule()
 {
 	// This code will execute after your module is loaded into memory; the exact timing is specified in the .uplugin file per-module
@@ -14,7 +33,7 @@ void FSimpleINIModule::ShutdownModule()
 {
 	// This function may be called during shutdown to clean up your module.  For modules that support dynamic reloading,
 	// we call this function before unloading the module.
-	
+	FIniFileWatcher::Get( ).Stop( );
 }
 
 #undef LOCTEXT_NAMESPACE
@@ -2,8 +2,258 @@
 
 #include "SimpleINIBPLibrary.h"
 #include "SimpleINI.h"
+#include "IniRegistry.h"
+#include "IniFileWatcher.h"
+#include "IniChangeNotifier.h"
+#include "IniStructBinder.h"
+#include "SimpleINIStats.h"
+#include "Misc/ScopeRWLock.h"
+#include "Misc/ScopeLock.h"
+#include "Async/Async.h"
+#include "Async/ParallelFor.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "LatentActions.h"
 
-TArray<TSharedPtr<IniFile>> USimpleINIBPLibrary::INIs;
+namespace
+{
+	FIniRegistry& GetRegistry( )
+	{
+		return FIniRegistry::Get( );
+	}
+
+	// only registers the file once it loaded, so other threads never see it half parsed
+	IniFilePtr FindOrLoadFile( const FString& Key, const FString& FilePath )
+	{
+		IniFilePtr Ini = GetRegistry( ).Find( Key );
+		if (!Ini)
+		{
+			IniFilePtr NewIni = MakeShared<IniFile, ESPMode::ThreadSafe>( );
+			if (!NewIni->LoadFile( FilePath ))
+			{
+				return nullptr;
+			}
+			NewIni->SetRecordChanges( FIniChangeNotifier::Get( ).HasSubscribers( Key ) );
+			Ini = GetRegistry( ).Add( Key, NewIni );
+		}
+		return Ini;
+	}
+
+	// What the file recorded while the caller held its write lock, handed to the
+	// subscribers once it is released: declare it ahead of the lock
+	struct FRecordedChanges
+	{
+		explicit FRecordedChanges( const FString& InPathKey )
+			: PathKey( InPathKey )
+		{
+		}
+		~FRecordedChanges( )
+		{
+			FIniChangeNotifier::Get( ).Broadcast( PathKey, MoveTemp( Changes ) );
+		}
+
+		void Take( IniFile& Ini )
+		{
+			Ini.TakeChanges( Changes );
+		}
+
+		FString PathKey;
+		TArray<IniValueChange> Changes;
+	};
+
+	// Runs Load on the open file under its write lock. A file that is not open yet is
+	// loaded into a new IniFile that is registered only once Load succeeded, so other
+	// threads never find it empty.
+	template <typename FunctorType>
+	bool LoadRegistered( const FString& Key, FunctorType Load )
+	{
+		IniFilePtr Ini = GetRegistry( ).Find( Key );
+		if (!Ini)
+		{
+			// nothing to compare a new file with, it records no changes
+			IniFilePtr NewIni = MakeShared<IniFile, ESPMode::ThreadSafe>( );
+			{
+				FWriteScopeLock WriteLock( NewIni->GetLock( ) );
+				if (!Load( *NewIni ))
+				{
+					return false;
+				}
+				NewIni->SetRecordChanges( FIniChangeNotifier::Get( ).HasSubscribers( Key ) );
+			}
+			Ini = GetRegistry( ).Add( Key, NewIni );
+			if (Ini == NewIni)
+			{
+				return true;
+			}
+			// another thread registered the file first, load into that one
+		}
+
+		FRecordedChanges Changes( Key );
+		FWriteScopeLock WriteLock( Ini->GetLock( ) );
+		const bool bLoaded = Load( *Ini );
+		Changes.Take( *Ini );
+		return bLoaded;
+	}
+
+	// the storage an open file asked for, the default one for a file not open yet
+	bool UsesCompactStorage( const FString& Key )
+	{
+		IniFilePtr Ini = GetRegistry( ).Find( Key );
+		if (!Ini)
+		{
+			return false;
+		}
+		FReadScopeLock ReadLock( Ini->GetLock( ) );
+		return Ini->UsesCompactStorage( );
+	}
+
+	// runs Read on the published snapshot when the file has one, else on the file under
+	// its read lock, or its write lock when Read is the first to look into the section
+	template <typename FunctorType>
+	bool ReadIni( const IniFile& Ini, const FString& SectionName, FunctorType Read )
+	{
+		IniSnapshotRef Snapshot = Ini.AcquireSnapshot( );
+		if (Snapshot.IsValid( ))
+		{
+			return Read( *Snapshot );
+		}
+		{
+			FReadScopeLock ReadLock( Ini.GetLock( ) );
+			if (Ini.IsSectionParsed( SectionName ))
+			{
+				return Read( Ini );
+			}
+		}
+		FWriteScopeLock WriteLock( Ini.GetLock( ) );
+		return Read( Ini );
+	}
+
+	// a file with an open batch stays registered until the batch is committed
+	bool IsInBatch( const IniFile& Ini )
+	{
+		FReadScopeLock ReadLock( Ini.GetLock( ) );
+		return Ini.IsInBatch( );
+	}
+
+	// the typed getters differ only in the IniFile/IniSnapshot method they call
+	template <typename FunctorType>
+	bool GetTyped( const FString& FilePath, const FString& SectionName, bool CloseAfterFinish, bool& IsValid, FunctorType Read )
+	{
+		IsValid = false;
+
+		const FString PathKey = FIniRegistry::NormalizePath( FilePath );
+		IniFilePtr Ini = FindOrLoadFile( PathKey, FilePath );
+		if (!Ini)
+		{
+			return false;
+		}
+
+		const bool bRet = ReadIni( *Ini, SectionName, Read );
+		if (CloseAfterFinish && !IsInBatch( *Ini ))
+		{
+			GetRegistry( ).Remove( PathKey );
+		}
+		return bRet;
+	}
+
+	// loads in flight, keyed like the registry; Id tells a load from a later one of the same file
+	struct FPendingLoad
+	{
+		TSharedFuture<bool> Future;
+		uint64 Id;
+		bool bClearContent;
+	};
+	FCriticalSection PendingLoadsLock;
+	TMap<FString, FPendingLoad> PendingLoads;
+	uint64 NextLoadId = 0;
+
+	// bJoinPending hands out the future of a load of the file still in flight instead, when
+	// that load clears the content the same way
+	TSharedFuture<bool> StartLoadAsync( const FString& FilePath, bool ClearContent, bool bJoinPending )
+	{
+		const FString PathKey = FIniRegistry::NormalizePath( FilePath );
+		TSharedRef<TPromise<bool>, ESPMode::ThreadSafe> Promise = MakeShared<TPromise<bool>, ESPMode::ThreadSafe>( );
+		TSharedFuture<bool> Future = Promise->GetFuture( ).Share( );
+		uint64 LoadId;
+		{
+			FScopeLock Lock( &PendingLoadsLock );
+			if (bJoinPending)
+			{
+				const FPendingLoad* Pending = PendingLoads.Find( PathKey );
+				if (Pending && Pending->bClearContent == ClearContent)
+				{
+					return Pending->Future;
+				}
+			}
+			LoadId = ++NextLoadId;
+			PendingLoads.Add( PathKey, FPendingLoad{ Future, LoadId, ClearContent } );
+		}
+
+		Async( EAsyncExecution::ThreadPool, [PathKey, FilePath, ClearContent, Promise, LoadId]( )
+		{
+			double ParseSeconds = 0.0;
+			TSharedPtr<IniRoot> NewRoot = IniFile::ParseFile( FilePath, ClearContent, ParseSeconds, false, UsesCompactStorage( PathKey ) );
+			const bool bLoaded = LoadRegistered( PathKey, [&]( IniFile& Ini )
+			{
+				return Ini.AdoptRoot( FilePath, NewRoot, ParseSeconds );
+			} );
+
+			{
+				// a later load may have taken the entry over, it removes it itself
+				FScopeLock Lock( &PendingLoadsLock );
+				const FPendingLoad* Pending = PendingLoads.Find( PathKey );
+				if (Pending && Pending->Id == LoadId)
+				{
+					PendingLoads.Remove( PathKey );
+				}
+			}
+			Promise->SetValue( bLoaded );
+		} );
+		return Future;
+	}
+
+	// resumes a latent Blueprint node once the future is ready
+	class FIniFutureAction : public FPendingLatentAction
+	{
+	public:
+		FIniFutureAction( const TSharedFuture<bool>& InFuture, bool& InSuccess, const FLatentActionInfo& LatentInfo )
+			: Future( InFuture )
+			, Success( InSuccess )
+			, ExecutionFunction( LatentInfo.ExecutionFunction )
+			, OutputLink( LatentInfo.Linkage )
+			, CallbackTarget( LatentInfo.CallbackTarget )
+		{
+		}
+
+		virtual void UpdateOperation( FLatentResponse& Response ) override
+		{
+			if (Future.IsReady( ))
+			{
+				Success = Future.Get( );
+				Response.FinishAndTriggerIf( true, ExecutionFunction, OutputLink, CallbackTarget );
+			}
+		}
+
+	private:
+		TSharedFuture<bool> Future;
+		bool& Success;
+		FName ExecutionFunction;
+		int32 OutputLink;
+		FWeakObjectPtr CallbackTarget;
+	};
+
+	void AddFutureAction( UObject* WorldContextObject, const TSharedFuture<bool>& Future, bool& Success, const FLatentActionInfo& LatentInfo )
+	{
+		if (UWorld* World = GEngine->GetWorldFromContextObject( WorldContextObject, EGetWorldErrorMode::LogAndReturnNull ))
+		{
+			FLatentActionManager& LatentManager = World->GetLatentActionManager( );
+			if (LatentManager.FindExistingAction<FIniFutureAction>( LatentInfo.CallbackTarget, LatentInfo.UUID ) == nullptr)
+			{
+				LatentManager.AddNewAction( LatentInfo.CallbackTarget, LatentInfo.UUID, new FIniFutureAction( Future, Success, LatentInfo ) );
+			}
+		}
+	}
+}
 
 USimpleINIBPLibrary::USimpleINIBPLibrary(const FObjectInitializer& ObjectInitializer)
 : Super(ObjectInitializer)
@@ -16,112 +266,601 @@ USimpleINIBPLibrary::USimpleINIBPLibrary(const FObjectInitializer& ObjectInitial
 //	return -1;
 //}
 
-bool USimpleINIBPLibrary::LoadIniFile( const FString& FilePath, bool ClearContent /*= false*/ )
+bool USimpleINIBPLibrary::LoadIniFile( const FString& FilePath, bool ClearContent /*= false*/, bool LazyParse /*= false*/ )
 {
-	TSharedPtr<IniFile> Ini = FindFileOpened( FilePath );
-	if (!Ini)
+	TRACE_CPUPROFILER_EVENT_SCOPE( SimpleINI_LoadIniFile );
+	return LoadRegistered( FIniRegistry::NormalizePath( FilePath ), [&]( IniFile& Ini )
+	{
+		return Ini.LoadFile( FilePath, ClearContent, LazyParse );
+	} );
+}
+
+bool USimpleINIBPLibrary::LoadIniFiles( const TArray<FString>& FilePaths, TArray<bool>& Loaded, bool ClearContent /*= false*/ )
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE( SimpleINI_LoadIniFiles );
+	TArray<FString> PathKeys;
+	TArray<bool> Compact;
+	for (const FString& FilePath : FilePaths)
 	{
-		Ini = TSharedPtr<IniFile>( new IniFile( ) );
-		INIs.Add( Ini );
+		const FString& PathKey = PathKeys.Add_GetRef( FIniRegistry::NormalizePath( FilePath ) );
+		Compact.Add( UsesCompactStorage( PathKey ) );
 	}
-	return Ini->LoadFile( FilePath, ClearContent );
+
+	TArray<TSharedPtr<IniRoot>> NewRoots;
+	TArray<double> ParseSeconds;
+	NewRoots.SetNum( FilePaths.Num( ) );
+	ParseSeconds.SetNumZeroed( FilePaths.Num( ) );
+	ParallelFor( FilePaths.Num( ), [&]( int32 i )
+	{
+		NewRoots[i] = IniFile::ParseFile( FilePaths[i], ClearContent, ParseSeconds[i], false, Compact[i] );
+	} );
+
+	bool bAllLoaded = true;
+	Loaded.SetNum( FilePaths.Num( ) );
+	for (int i = 0; i < FilePaths.Num( ); ++i)
+	{
+		Loaded[i] = LoadRegistered( PathKeys[i], [&]( IniFile& Ini )
+		{
+			return Ini.AdoptRoot( FilePaths[i], NewRoots[i], ParseSeconds[i] );
+		} );
+		bAllLoaded = bAllLoaded && Loaded[i];
+	}
+	return bAllLoaded;
+}
+
+bool USimpleINIBPLibrary::LoadIniFileCached( const FString& FilePath, const FString& CacheDirectory )
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE( SimpleINI_LoadIniFileCached );
+	return LoadRegistered( FIniRegistry::NormalizePath( FilePath ), [&]( IniFile& Ini )
+	{
+		return Ini.LoadFileCached( FilePath, CacheDirectory );
+	} );
+}
+
+bool USimpleINIBPLibrary::LoadIniFileMapped( const FString& FilePath )
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE( SimpleINI_LoadIniFileMapped );
+	// read-only documents record nothing
+	return LoadRegistered( FIniRegistry::NormalizePath( FilePath ), [&]( IniFile& Ini )
+	{
+		return Ini.LoadFileMapped( FilePath );
+	} );
+}
+
+bool USimpleINIBPLibrary::LoadIniFileCompact( const FString& FilePath )
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE( SimpleINI_LoadIniFileCompact );
+	return LoadRegistered( FIniRegistry::NormalizePath( FilePath ), [&]( IniFile& Ini )
+	{
+		Ini.SetCompactStorage( true );
+		return Ini.LoadFile( FilePath );
+	} );
 }
 
 bool USimpleINIBPLibrary::GetValue( const FString& FilePath, const FString& SectionName, const FString& Key, FString& Value, bool& IsValid, bool CloseAfterFinish/* = false*/ )
 {
-	TSharedPtr<IniFile> Ini = FindFileOpened( FilePath );
+	TRACE_CPUPROFILER_EVENT_SCOPE( SimpleINI_GetValue );
+	IsValid = false;
+
+	const FString PathKey = FIniRegistry::NormalizePath( FilePath );
+	IniFilePtr Ini = FindOrLoadFile( PathKey, FilePath );
 	if (!Ini)
 	{
-		Ini = TSharedPtr<IniFile>( new IniFile( ) );
-		INIs.Add( Ini );
-		if (!Ini->LoadFile( FilePath ))
-		{ 
-			return false;
-		}
+		return false;
 	}
 
-	bool bRet = Ini->GetValue( SectionName, Key, Value, IsValid );
-	if (CloseAfterFinish)
+	const bool bRet = ReadIni( *Ini, SectionName, [&]( const auto& Source )
+	{
+		return Source.GetValue( SectionName, Key, Value, IsValid );
+	} );
+	if (CloseAfterFinish && !IsInBatch( *Ini ))
+	{
+		GetRegistry( ).Remove( PathKey );
+	}
+	return bRet;
+}
+
+bool USimpleINIBPLibrary::GetSection( const FString& FilePath, const FString& SectionName, TMap<FString, FString>& Values, bool CloseAfterFinish/* = false*/ )
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE( SimpleINI_GetSection );
+	Values.Reset( );
+
+	const FString PathKey = FIniRegistry::NormalizePath( FilePath );
+	IniFilePtr Ini = FindOrLoadFile( PathKey, FilePath );
+	if (!Ini)
+	{
+		return false;
+	}
+
+	const bool bRet = ReadIni( *Ini, SectionName, [&]( const auto& Source )
+	{
+		return Source.GetSection( SectionName, Values );
+	} );
+	if (CloseAfterFinish && !IsInBatch( *Ini ))
+	{
+		GetRegistry( ).Remove( PathKey );
+	}
+	return bRet;
+}
+
+bool USimpleINIBPLibrary::GetValues( const FString& FilePath, const FString& SectionName, const TArray<FString>& Keys, TArray<FString>& Values, TArray<bool>& IsValid, bool CloseAfterFinish/* = false*/ )
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE( SimpleINI_GetValues );
+	const FString PathKey = FIniRegistry::NormalizePath( FilePath );
+	IniFilePtr Ini = FindOrLoadFile( PathKey, FilePath );
+	if (!Ini)
+	{
+		Values.Init( FString( ), Keys.Num( ) );
+		IsValid.Init( false, Keys.Num( ) );
+		return false;
+	}
+
+	const bool bRet = ReadIni( *Ini, SectionName, [&]( const auto& Source )
+	{
+		return Source.GetValues( SectionName, Keys, Values, IsValid );
+	} );
+	if (CloseAfterFinish && !IsInBatch( *Ini ))
+	{
+		GetRegistry( ).Remove( PathKey );
+	}
+	return bRet;
+}
+
+bool USimpleINIBPLibrary::GetIntValue( const FString& FilePath, const FString& SectionName, const FString& Key, int32& Value, bool& IsValid, bool CloseAfterFinish/* = false*/ )
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE( SimpleINI_GetIntValue );
+	return GetTyped( FilePath, SectionName, CloseAfterFinish, IsValid, [&]( const auto& Source )
+	{
+		return Source.GetInt( SectionName, Key, Value, IsValid );
+	} );
+}
+
+bool USimpleINIBPLibrary::GetFloatValue( const FString& FilePath, const FString& SectionName, const FString& Key, float& Value, bool& IsValid, bool CloseAfterFinish/* = false*/ )
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE( SimpleINI_GetFloatValue );
+	return GetTyped( FilePath, SectionName, CloseAfterFinish, IsValid, [&]( const auto& Source )
+	{
+		return Source.GetFloat( SectionName, Key, Value, IsValid );
+	} );
+}
+
+bool USimpleINIBPLibrary::GetBoolValue( const FString& FilePath, const FString& SectionName, const FString& Key, bool& Value, bool& IsValid, bool CloseAfterFinish/* = false*/ )
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE( SimpleINI_GetBoolValue );
+	return GetTyped( FilePath, SectionName, CloseAfterFinish, IsValid, [&]( const auto& Source )
+	{
+		return Source.GetBool( SectionName, Key, Value, IsValid );
+	} );
+}
+
+bool USimpleINIBPLibrary::GetVectorValue( const FString& FilePath, const FString& SectionName, const FString& Key, FVector& Value, bool& IsValid, bool CloseAfterFinish/* = false*/ )
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE( SimpleINI_GetVectorValue );
+	return GetTyped( FilePath, SectionName, CloseAfterFinish, IsValid, [&]( const auto& Source )
+	{
+		return Source.GetVector( SectionName, Key, Value, IsValid );
+	} );
+}
+
+bool USimpleINIBPLibrary::GetArrayValue( const FString& FilePath, const FString& SectionName, const FString& Key, TArray<FString>& Value, bool& IsValid, bool CloseAfterFinish/* = false*/ )
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE( SimpleINI_GetArrayValue );
+	return GetTyped( FilePath, SectionName, CloseAfterFinish, IsValid, [&]( const auto& Source )
+	{
+		return Source.GetArray( SectionName, Key, Value, IsValid );
+	} );
+}
+
+bool USimpleINIBPLibrary::GetSectionAsStruct( const FString& FilePath, const FString& SectionName, int32& Value, int32& NumSet, bool CloseAfterFinish/* = false*/ )
+{
+	// only reached through execGetSectionAsStruct
+	check( 0 );
+	return false;
+}
+
+DEFINE_FUNCTION( USimpleINIBPLibrary::execGetSectionAsStruct )
+{
+	P_GET_PROPERTY( FStrProperty, FilePath );
+	P_GET_PROPERTY( FStrProperty, SectionName );
+	Stack.MostRecentPropertyAddress = nullptr;
+	Stack.StepCompiledIn<FStructProperty>( nullptr );
+	void* ValueData = Stack.MostRecentPropertyAddress;
+	FStructProperty* ValueProperty = CastField<FStructProperty>( Stack.MostRecentProperty );
+	P_GET_PROPERTY_REF( FIntProperty, NumSet );
+	P_GET_UBOOL( CloseAfterFinish );
+	P_FINISH;
+
+	bool bRet = false;
+	P_NATIVE_BEGIN;
+	NumSet = 0;
+	if (ValueProperty && ValueData)
+	{
+		bRet = GetIniStruct( FilePath, SectionName, ValueProperty->Struct, ValueData, NumSet, CloseAfterFinish );
+	}
+	P_NATIVE_END;
+	*(bool*)RESULT_PARAM = bRet;
+}
+
+bool USimpleINIBPLibrary::GetSectionAsObject( const FString& FilePath, const FString& SectionName, UObject* Object, int32& NumSet, bool CloseAfterFinish/* = false*/ )
+{
+	NumSet = 0;
+	return Object && GetIniStruct( FilePath, SectionName, Object->GetClass( ), Object, NumSet, CloseAfterFinish );
+}
+
+bool USimpleINIBPLibrary::GetIniStruct( const FString& FilePath, const FString& SectionName, const UStruct* Struct, void* Data, int32& NumSet, bool CloseAfterFinish/* = false*/ )
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE( SimpleINI_GetIniStruct );
+	NumSet = 0;
+	if (!Struct || !Data)
+	{
+		return false;
+	}
+	const FIniStructBinder& Binder = FIniStructBinder::Get( Struct );
+
+	const FString PathKey = FIniRegistry::NormalizePath( FilePath );
+	IniFilePtr Ini = FindOrLoadFile( PathKey, FilePath );
+	if (!Ini)
+	{
+		return false;
+	}
+
+	const bool bRet = ReadIni( *Ini, SectionName, [&]( const auto& Source )
 	{
-		CloseIniFile( FilePath );
+		return Source.GetStruct( SectionName, Binder, Data, NumSet );
+	} );
+	if (CloseAfterFinish && !IsInBatch( *Ini ))
+	{
+		GetRegistry( ).Remove( PathKey );
 	}
 	return bRet;
 }
 
 bool USimpleINIBPLibrary::SetValue( const FString& FilePath, const FString& SectionName, const FString& Key, const FString& Value, bool CloseAfterFinish/* = false*/ )
 {
-	TSharedPtr<IniFile> Ini = FindFileOpened( FilePath );
+	TRACE_CPUPROFILER_EVENT_SCOPE( SimpleINI_SetValue );
+	const FString PathKey = FIniRegistry::NormalizePath( FilePath );
+	IniFilePtr Ini = FindOrLoadFile( PathKey, FilePath );
 	if (!Ini)
 	{
-		Ini = TSharedPtr<IniFile>( new IniFile( ) );
-		INIs.Add( Ini );
-		if (!Ini->LoadFile( FilePath ))
+		return false;
+	}
+
+	bool bRet;
+	bool bInBatch;
+	{
+		FRecordedChanges Changes( PathKey );
+		FWriteScopeLock WriteLock( Ini->GetLock( ) );
+		bRet = Ini->SetValue( SectionName, Key, Value );
+		bInBatch = Ini->IsInBatch( );
+		if (CloseAfterFinish && !bInBatch)
 		{
-			return false;
+			bRet = (Ini->Save( ) && bRet);
 		}
+		Changes.Take( *Ini );
+	}
+	if (CloseAfterFinish && !bInBatch)
+	{
+		GetRegistry( ).Remove( PathKey );
 	}
+	return bRet;
+}
 
-	bool bRet = Ini->SetValue( SectionName, Key, Value );
-	if (CloseAfterFinish)
+bool USimpleINIBPLibrary::SetSectionFromStruct( const FString& FilePath, const FString& SectionName, const int32& Value, bool CloseAfterFinish/* = false*/ )
+{
+	// only reached through execSetSectionFromStruct
+	check( 0 );
+	return false;
+}
+
+DEFINE_FUNCTION( USimpleINIBPLibrary::execSetSectionFromStruct )
+{
+	P_GET_PROPERTY( FStrProperty, FilePath );
+	P_GET_PROPERTY( FStrProperty, SectionName );
+	Stack.MostRecentPropertyAddress = nullptr;
+	Stack.StepCompiledIn<FStructProperty>( nullptr );
+	const void* ValueData = Stack.MostRecentPropertyAddress;
+	FStructProperty* ValueProperty = CastField<FStructProperty>( Stack.MostRecentProperty );
+	P_GET_UBOOL( CloseAfterFinish );
+	P_FINISH;
+
+	bool bRet = false;
+	P_NATIVE_BEGIN;
+	if (ValueProperty && ValueData)
 	{
-		bRet = (Ini->Save( ) && bRet);
-		CloseIniFile( FilePath );
+		bRet = SetIniStruct( FilePath, SectionName, ValueProperty->Struct, ValueData, CloseAfterFinish );
+	}
+	P_NATIVE_END;
+	*(bool*)RESULT_PARAM = bRet;
+}
+
+bool USimpleINIBPLibrary::SetSectionFromObject( const FString& FilePath, const FString& SectionName, UObject* Object, bool CloseAfterFinish/* = false*/ )
+{
+	return Object && SetIniStruct( FilePath, SectionName, Object->GetClass( ), Object, CloseAfterFinish );
+}
+
+bool USimpleINIBPLibrary::SetIniStruct( const FString& FilePath, const FString& SectionName, const UStruct* Struct, const void* Data, bool CloseAfterFinish/* = false*/ )
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE( SimpleINI_SetIniStruct );
+	if (!Struct || !Data)
+	{
+		return false;
+	}
+	const FIniStructBinder& Binder = FIniStructBinder::Get( Struct );
+
+	const FString PathKey = FIniRegistry::NormalizePath( FilePath );
+	IniFilePtr Ini = FindOrLoadFile( PathKey, FilePath );
+	if (!Ini)
+	{
+		return false;
+	}
+
+	bool bRet;
+	bool bInBatch;
+	{
+		FRecordedChanges Changes( PathKey );
+		FWriteScopeLock WriteLock( Ini->GetLock( ) );
+		bRet = Ini->SetStruct( SectionName, Binder, Data );
+		bInBatch = Ini->IsInBatch( );
+		if (CloseAfterFinish && !bInBatch)
+		{
+			bRet = (Ini->Save( ) && bRet);
+		}
+		Changes.Take( *Ini );
+	}
+	if (CloseAfterFinish && !bInBatch)
+	{
+		GetRegistry( ).Remove( PathKey );
 	}
 	return bRet;
 }
 
 bool USimpleINIBPLibrary::SaveIniFile( const FString& FilePath, bool CloseAfterFinish/* = false*/ )
 {
-	TSharedPtr<IniFile> Ini = FindFileOpened( FilePath );
+	TRACE_CPUPROFILER_EVENT_SCOPE( SimpleINI_SaveIniFile );
+	const FString PathKey = FIniRegistry::NormalizePath( FilePath );
+	IniFilePtr Ini = GetRegistry( ).Find( PathKey );
 	if (!Ini)
 	{
 		return false;
 	}
 
-	bool bRet = Ini->Save( );
+	bool bRet;
+	{
+		FWriteScopeLock WriteLock( Ini->GetLock( ) );
+		if (Ini->IsInBatch( ))
+		{
+			UE_LOG( LogSimpleINI, Warning, TEXT( "Not saving %s while a batch is open, CommitIniBatch saves it" ), *FilePath );
+			return false;
+		}
+		bRet = Ini->Save( );
+	}
 	if (CloseAfterFinish)
 	{
-		CloseIniFile( FilePath );
+		GetRegistry( ).Remove( PathKey );
 	}
 	return bRet;
 }
 
+bool USimpleINIBPLibrary::SaveIniFileToBytes( const FString& FilePath, TArray<uint8>& Bytes )
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE( SimpleINI_SaveIniFileToBytes );
+	Bytes.Reset( );
+	IniFilePtr Ini = GetRegistry( ).Find( FIniRegistry::NormalizePath( FilePath ) );
+	if (!Ini)
+	{
+		return false;
+	}
+
+	// pending sections get parsed
+	FWriteScopeLock WriteLock( Ini->GetLock( ) );
+	return Ini->SaveToBytes( Bytes );
+}
+
 bool USimpleINIBPLibrary::ReloadIniFile( const FString& FilePath )
 {
-	TSharedPtr<IniFile> Ini = FindFileOpened( FilePath );
+	TRACE_CPUPROFILER_EVENT_SCOPE( SimpleINI_ReloadIniFile );
+	return LoadRegistered( FIniRegistry::NormalizePath( FilePath ), [&]( IniFile& Ini )
+	{
+		return Ini.LoadFile( FilePath );
+	} );
+}
+
+bool USimpleINIBPLibrary::GetParsedSectionCount( const FString& FilePath, int32& ParsedSections, int32& TotalSections )
+{
+	ParsedSections = 0;
+	TotalSections = 0;
+	IniFilePtr Ini = GetRegistry( ).Find( FIniRegistry::NormalizePath( FilePath ) );
 	if (!Ini)
 	{
-		Ini = TSharedPtr<IniFile>( new IniFile( ) );
-		INIs.Add( Ini );
+		return false;
 	}
 
-	return Ini->LoadFile( FilePath );
+	FReadScopeLock ReadLock( Ini->GetLock( ) );
+	ParsedSections = Ini->GetNumSectionsParsed( );
+	TotalSections = Ini->GetNumSections( );
+	return true;
 }
 
 void USimpleINIBPLibrary::CloseIniFile( const FString& FilePath )
 {
-	for (int i = 0; i < INIs.Num( ); ++i)
+	GetRegistry( ).Remove( FIniRegistry::NormalizePath( FilePath ) );
+}
+
+bool USimpleINIBPLibrary::BeginIniBatch( const FString& FilePath )
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE( SimpleINI_BeginIniBatch );
+	IniFilePtr Ini = FindOrLoadFile( FIniRegistry::NormalizePath( FilePath ), FilePath );
+	if (!Ini)
 	{
-		TSharedPtr<IniFile> Ini = INIs[i];
-		if (Ini && (Ini->mFilePath == FilePath))
-		{
-			INIs.RemoveAt( i );
-			return;
-		}
+		return false;
+	}
+
+	FWriteScopeLock WriteLock( Ini->GetLock( ) );
+	return Ini->BeginBatch( );
+}
+
+bool USimpleINIBPLibrary::CommitIniBatch( const FString& FilePath, bool CloseAfterFinish /*= false*/ )
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE( SimpleINI_CommitIniBatch );
+	const FString PathKey = FIniRegistry::NormalizePath( FilePath );
+	IniFilePtr Ini = GetRegistry( ).Find( PathKey );
+	if (!Ini)
+	{
+		return false;
+	}
+
+	bool bRet;
+	bool bInBatch;
+	{
+		FRecordedChanges Changes( PathKey );
+		FWriteScopeLock WriteLock( Ini->GetLock( ) );
+		bRet = Ini->CommitBatch( );
+		bInBatch = Ini->IsInBatch( );
+		Changes.Take( *Ini );
+	}
+	if (CloseAfterFinish && !bInBatch)
+	{
+		GetRegistry( ).Remove( PathKey );
+	}
+	return bRet;
+}
+
+void USimpleINIBPLibrary::RollbackIniBatch( const FString& FilePath )
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE( SimpleINI_RollbackIniBatch );
+	if (IniFilePtr Ini = GetRegistry( ).Find( FIniRegistry::NormalizePath( FilePath ) ))
+	{
+		FWriteScopeLock WriteLock( Ini->GetLock( ) );
+		Ini->RollbackBatch( );
 	}
 }
 
-TSharedPtr<IniFile> USimpleINIBPLibrary::FindFileOpened( const FString& FilePath )
+bool USimpleINIBPLibrary::SetSnapshotReads( const FString& FilePath, bool bEnable )
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE( SimpleINI_SetSnapshotReads );
+	const FString PathKey = FIniRegistry::NormalizePath( FilePath );
+	IniFilePtr Ini = FindOrLoadFile( PathKey, FilePath );
+	if (!Ini)
+	{
+		return false;
+	}
+
+	FWriteScopeLock WriteLock( Ini->GetLock( ) );
+	Ini->SetSnapshotReads( bEnable );
+	return true;
+}
+
+void USimpleINIBPLibrary::SetWatchFiles( bool bEnable, float DebounceSeconds /*= 0.25f*/ )
+{
+	if (bEnable)
+	{
+		FIniFileWatcher::Get( ).Start( DebounceSeconds );
+	}
+	else
+	{
+		FIniFileWatcher::Get( ).Stop( );
+	}
+}
+
+UIniChangeSubscription* USimpleINIBPLibrary::SubscribeToIniChanges( const FString& FilePath, const FString& SectionName, const FString& Key )
+{
+	UIniChangeSubscription* Subscription = NewObject<UIniChangeSubscription>( );
+	Subscription->Subscribe( FilePath, SectionName, Key );
+	return Subscription;
+}
+
+TSharedFuture<bool> USimpleINIBPLibrary::LoadIniFileAsync( const FString& FilePath, bool ClearContent /*= false*/ )
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE( SimpleINI_LoadIniFileAsync );
+	return StartLoadAsync( FilePath, ClearContent, true );
+}
+
+TSharedFuture<bool> USimpleINIBPLibrary::ReloadIniFileAsync( const FString& FilePath )
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE( SimpleINI_ReloadIniFileAsync );
+	// a load in flight may have read the file before it changed
+	return StartLoadAsync( FilePath, false, false );
+}
+
+TFuture<bool> USimpleINIBPLibrary::SaveIniFileAsync( const FString& FilePath, bool CloseAfterFinish /*= false*/ )
 {
-	for (int i = 0; i < INIs.Num( ); ++i)
+	TRACE_CPUPROFILER_EVENT_SCOPE( SimpleINI_SaveIniFileAsync );
+	const FString PathKey = FIniRegistry::NormalizePath( FilePath );
+	IniFilePtr Ini = GetRegistry( ).Find( PathKey );
+	if (!Ini)
 	{
-		TSharedPtr<IniFile> Ini = INIs[i];
-		if (Ini && (Ini->mFilePath == FilePath))
+		TPromise<bool> Promise;
+		Promise.SetValue( false );
+		return Promise.GetFuture( );
+	}
+
+	return Async( EAsyncExecution::ThreadPool, [Ini, PathKey, FilePath, CloseAfterFinish]( ) -> bool
+	{
+		bool bRet;
 		{
-			return Ini;
+			FWriteScopeLock WriteLock( Ini->GetLock( ) );
+			if (Ini->IsInBatch( ))
+			{
+				UE_LOG( LogSimpleINI, Warning, TEXT( "Not saving %s while a batch is open, CommitIniBatch saves it" ), *FilePath );
+				return false;
+			}
+			bRet = Ini->Save( );
 		}
-	}
+		if (CloseAfterFinish)
+		{
+			GetRegistry( ).Remove( PathKey );
+		}
+		return bRet;
+	} );
+}
+
+void USimpleINIBPLibrary::LoadIniFileLatent( UObject* WorldContextObject, const FString& FilePath, bool ClearContent, bool& Success, FLatentActionInfo LatentInfo )
+{
+	AddFutureAction( WorldContextObject, LoadIniFileAsync( FilePath, ClearContent ), Success, LatentInfo );
+}
 
-	return nullptr;
+void USimpleINIBPLibrary::ReloadIniFileLatent( UObject* WorldContextObject, const FString& FilePath, bool& Success, FLatentActionInfo LatentInfo )
+{
+	AddFutureAction( WorldContextObject, ReloadIniFileAsync( FilePath ), Success, LatentInfo );
+}
+
+void USimpleINIBPLibrary::SaveIniFileLatent( UObject* WorldContextObject, const FString& FilePath, bool CloseAfterFinish, bool& Success, FLatentActionInfo LatentInfo )
+{
+	AddFutureAction( WorldContextObject, SaveIniFileAsync( FilePath, CloseAfterFinish ).Share( ), Success, LatentInfo );
 }
 
+IniFilePtr USimpleINIBPLibrary::FindFileOpened( const FString& FilePath )
+{
+	return GetRegistry( ).Find( FIniRegistry::NormalizePath( FilePath ) );
+}
+
+FIniBatchScope::FIniBatchScope( const FString& InFilePath, bool bInCloseAfterFinish /*= false*/ )
+	: FilePath( InFilePath )
+	, bCloseAfterFinish( bInCloseAfterFinish )
+{
+	bActive = USimpleINIBPLibrary::BeginIniBatch( FilePath );
+}
+
+FIniBatchScope::~FIniBatchScope( )
+{
+	Commit( );
+}
+
+bool FIniBatchScope::Commit( )
+{
+	if (!bActive)
+	{
+		return false;
+	}
+	bActive = false;
+	return USimpleINIBPLibrary::CommitIniBatch( FilePath, bCloseAfterFinish );
+}
+
+void FIniBatchScope::Rollback( )
+{
+	if (bActive)
+	{
+		bActive = false;
+		USimpleINIBPLibrary::RollbackIniBatch( FilePath );
+	}
+}
@@ -0,0 +1,359 @@
+#include "CoreMinimal.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformMemory.h"
+#include "Math/RandomStream.h"
+#include "Misc/App.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "SimpleINI.h"
+#include "IniScanner.h"
+#include "ini.h"
+
+#if !UE_BUILD_SHIPPING
+
+namespace
+{
+	// the per-line classification the parser used before IniScanner: a trimmed copy, then Find("//") and Find("=")
+	int32 CountPairsPerLine( const FString& Text )
+	{
+		TArray<FString> Lines;
+		Text.ParseIntoArrayLines( Lines, false );
+
+		int32 NumPairs = 0;
+		for (int i = 0; i < Lines.Num( ); ++i)
+		{
+			FString TrimedString = Lines[i].TrimStartAndEnd( );
+			if (TrimedString.IsEmpty( )
+				|| TrimedString[0] == TEXT( '#' )
+				|| TrimedString.Find( TEXT( "//" ) ) == 0)
+			{
+				continue;
+			}
+			if (TrimedString.Find( TEXT( "=" ) ) > 0)
+			{
+				++NumPairs;
+			}
+		}
+		return NumPairs;
+	}
+
+	int32 CountPairsScanned( const FString& Text, TArray<IniScannedLine>& Lines )
+	{
+		IniScanner::ScanLines( *Text, Text.Len( ), Lines );
+
+		int32 NumPairs = 0;
+		for (int i = 0; i < Lines.Num( ); ++i)
+		{
+			NumPairs += (Lines[i].Kind == EIniLineKind::NameValue) ? 1 : 0;
+		}
+		return NumPairs;
+	}
+
+	void RunScanBenchmark( const TArray<FString>& Args )
+	{
+		if (Args.Num( ) < 1)
+		{
+			UE_LOG( LogSimpleINI, Display, TEXT( "Usage: SimpleINI.ScanBenchmark <file> [iterations]" ) );
+			return;
+		}
+
+		FString Text;
+		if (!FFileHelper::LoadFileToString( Text, *Args[0] ))
+		{
+			UE_LOG( LogSimpleINI, Error, TEXT( "SimpleINI.ScanBenchmark: cannot read %s" ), *Args[0] );
+			return;
+		}
+		const int32 Iterations = (Args.Num( ) > 1) ? FMath::Max( 1, FCString::Atoi( *Args[1] ) ) : 10;
+		const double Bytes = (double)Text.Len( ) * sizeof( TCHAR ) * Iterations;
+
+		int32 LinePairs = 0;
+		double StartTime = FPlatformTime::Seconds( );
+		for (int i = 0; i < Iterations; ++i)
+		{
+			LinePairs = CountPairsPerLine( Text );
+		}
+		const double LineSeconds = FPlatformTime::Seconds( ) - StartTime;
+
+		int32 ScannedPairs = 0;
+		TArray<IniScannedLine> Lines;
+		StartTime = FPlatformTime::Seconds( );
+		for (int i = 0; i < Iterations; ++i)
+		{
+			ScannedPairs = CountPairsScanned( Text, Lines );
+		}
+		const double ScanSeconds = FPlatformTime::Seconds( ) - StartTime;
+
+		UE_LOG( LogSimpleINI, Display, TEXT( "SimpleINI.ScanBenchmark %s: per-line FString %.3f GB/s, scanner (%s) %.3f GB/s (%.1fx), %d/%d pairs" ),
+			*Args[0],
+			Bytes / FMath::Max( LineSeconds, 1e-9 ) / 1e9,
+			IniScanner::GetPathName( ),
+			Bytes / FMath::Max( ScanSeconds, 1e-9 ) / 1e9,
+			LineSeconds / FMath::Max( ScanSeconds, 1e-9 ),
+			LinePairs, ScannedPairs );
+	}
+
+	FAutoConsoleCommand ScanBenchmarkCommand(
+		TEXT( "SimpleINI.ScanBenchmark" ),
+		TEXT( "Compares line classification throughput of IniScanner against per-line FString parsing. Usage: SimpleINI.ScanBenchmark <file> [iterations]" ),
+		FConsoleCommandWithArgsDelegate::CreateStatic( &RunScanBenchmark ) );
+
+	// shape of a synthetic file; the generator keeps adding sections until Bytes is reached
+	struct FCorpusSpec
+	{
+		int64 Bytes;
+		int32 KeysPerSection;
+		int32 CommentEvery;		// one comment line per this many keys, 0 for none
+		int32 ValueLen;
+	};
+
+	// Writes the corpus and returns the number of sections it got. Section i has the
+	// keys Key0 .. Key(KeysPerSection - 1), so lookups can pick existing keys blindly.
+	int32 WriteCorpus( const FString& FilePath, const FCorpusSpec& Spec )
+	{
+		TUniquePtr<FArchive> Writer( IFileManager::Get( ).CreateFileWriter( *FilePath ) );
+		if (!Writer)
+		{
+			return 0;
+		}
+
+		FRandomStream Random( 1234 );
+		TArray<ANSICHAR> Chunk;
+		TArray<ANSICHAR> Value;
+		Value.SetNumUninitialized( Spec.ValueLen );
+
+		int64 Written = 0;
+		int32 NumSections = 0;
+		while (Written < Spec.Bytes)
+		{
+			const FString Header = FString::Printf( TEXT( "[Section%d]\r\n" ), NumSections++ );
+			Chunk.Append( TCHAR_TO_ANSI( *Header ), Header.Len( ) );
+			for (int32 Key = 0; Key < Spec.KeysPerSection; ++Key)
+			{
+				if (Spec.CommentEvery > 0 && Key % Spec.CommentEvery == 0)
+				{
+					const char Comment[] = "# generated comment line\r\n";
+					Chunk.Append( Comment, sizeof( Comment ) - 1 );
+				}
+				for (int32 i = 0; i < Spec.ValueLen; ++i)
+				{
+					Value[i] = 'a' + Random.RandRange( 0, 25 );
+				}
+				const FString Line = FString::Printf( TEXT( "Key%d=" ), Key );
+				Chunk.Append( TCHAR_TO_ANSI( *Line ), Line.Len( ) );
+				Chunk.Append( Value );
+				Chunk.Append( "\r\n", 2 );
+			}
+			if (Chunk.Num( ) >= 1024 * 1024 || Written + Chunk.Num( ) >= Spec.Bytes)
+			{
+				Writer->Serialize( Chunk.GetData( ), Chunk.Num( ) );
+				Written += Chunk.Num( );
+				Chunk.Reset( );
+			}
+		}
+		return Writer->Close( ) ? NumSections : 0;
+	}
+
+	// nearest-rank percentile of sorted samples
+	double Percentile( const TArray<double>& Sorted, double Fraction )
+	{
+		if (Sorted.Num( ) == 0)
+		{
+			return 0.0;
+		}
+		const int32 Index = FMath::Clamp( FMath::CeilToInt( Fraction * Sorted.Num( ) ) - 1, 0, Sorted.Num( ) - 1 );
+		return Sorted[Index];
+	}
+
+	int64 ParseSize( const FString& Text )
+	{
+		int64 Scale = 1;
+		FString Number = Text;
+		if (Text.EndsWith( TEXT( "K" ) ))
+		{
+			Scale = 1024;
+		}
+		else if (Text.EndsWith( TEXT( "M" ) ))
+		{
+			Scale = 1024 * 1024;
+		}
+		else if (Text.EndsWith( TEXT( "G" ) ))
+		{
+			Scale = 1024 * 1024 * 1024;
+		}
+		if (Scale > 1)
+		{
+			Number.LeftChopInline( 1 );
+		}
+		return FCString::Atoi64( *Number ) * Scale;
+	}
+
+	// one JSON object per corpus size
+	FString RunCorpusBenchmark( const FString& FilePath, const FCorpusSpec& Spec, int32 NumLookups )
+	{
+		const int32 NumSections = WriteCorpus( FilePath, Spec );
+		if (NumSections == 0)
+		{
+			UE_LOG( LogSimpleINI, Error, TEXT( "SimpleINI.Benchmark: cannot write %s" ), *FilePath );
+			return FString( );
+		}
+		const int64 FileBytes = IFileManager::Get( ).FileSize( *FilePath );
+
+		const uint64 UsedBefore = FPlatformMemory::GetStats( ).UsedPhysical;
+		IniFile Ini;
+		double StartTime = FPlatformTime::Seconds( );
+		Ini.LoadFile( FilePath );
+		const double LoadSeconds = FPlatformTime::Seconds( ) - StartTime;
+		const FPlatformMemoryStats Stats = FPlatformMemory::GetStats( );
+		const int64 LoadedBytes = (int64)Stats.UsedPhysical - (int64)UsedBefore;
+
+		FRandomStream Random( 5678 );
+		TArray<double> Latencies;
+		Latencies.Reserve( NumLookups );
+		int32 NumFound = 0;
+		for (int i = 0; i < NumLookups; ++i)
+		{
+			const FString SectionName = FString::Printf( TEXT( "Section%d" ), Random.RandRange( 0, NumSections - 1 ) );
+			const FString Name = FString::Printf( TEXT( "Key%d" ), Random.RandRange( 0, Spec.KeysPerSection - 1 ) );
+			FStringView Value;
+			bool IsValid = false;
+			const uint64 StartCycles = FPlatformTime::Cycles64( );
+			Ini.GetValueView( SectionName, Name, Value, IsValid );
+			Latencies.Add( FPlatformTime::ToSeconds64( FPlatformTime::Cycles64( ) - StartCycles ) * 1e9 );
+			NumFound += IsValid ? 1 : 0;
+		}
+		Latencies.Sort( );
+
+		StartTime = FPlatformTime::Seconds( );
+		for (int i = 0; i < 1000; ++i)
+		{
+			Ini.SetValue( FString::Printf( TEXT( "Section%d" ), i % NumSections ), TEXT( "Key0" ), TEXT( "changed" ) );
+		}
+		const double SetSeconds = FPlatformTime::Seconds( ) - StartTime;
+
+		// a longer first value moves every line behind it, so the whole file is written
+		Ini.SetValue( TEXT( "Section0" ), TEXT( "Key0" ), FString::ChrN( Spec.ValueLen + 64, TEXT( 'z' ) ) );
+		StartTime = FPlatformTime::Seconds( );
+		const bool bSaved = Ini.Save( );
+		const double SaveSeconds = FPlatformTime::Seconds( ) - StartTime;
+
+		// the same corpus in compact storage; its lookups copy the value out
+		IniFile CompactIni;
+		CompactIni.SetCompactStorage( true );
+		StartTime = FPlatformTime::Seconds( );
+		CompactIni.LoadFile( FilePath );
+		const double CompactLoadSeconds = FPlatformTime::Seconds( ) - StartTime;
+		TArray<double> CompactLatencies;
+		CompactLatencies.Reserve( NumLookups );
+		Random.Initialize( 5678 );
+		for (int i = 0; i < NumLookups; ++i)
+		{
+			const FString SectionName = FString::Printf( TEXT( "Section%d" ), Random.RandRange( 0, NumSections - 1 ) );
+			const FString Name = FString::Printf( TEXT( "Key%d" ), Random.RandRange( 0, Spec.KeysPerSection - 1 ) );
+			FString Value;
+			bool IsValid = false;
+			const uint64 StartCycles = FPlatformTime::Cycles64( );
+			CompactIni.GetValue( SectionName, Name, Value, IsValid );
+			CompactLatencies.Add( FPlatformTime::ToSeconds64( FPlatformTime::Cycles64( ) - StartCycles ) * 1e9 );
+		}
+		CompactLatencies.Sort( );
+
+		const double MB = FileBytes / (1024.0 * 1024.0);
+		UE_LOG( LogSimpleINI, Display, TEXT( "SimpleINI.Benchmark %.1f MB: load %.1f MB/s, lookup p50 %.0f ns p99 %.0f ns, set %.0f ns, save %.1f MB/s%s" ),
+			MB, MB / FMath::Max( LoadSeconds, 1e-9 ), Percentile( Latencies, 0.5 ), Percentile( Latencies, 0.99 ),
+			SetSeconds / 1000 * 1e9, MB / FMath::Max( SaveSeconds, 1e-9 ), bSaved ? TEXT( "" ) : TEXT( " (save failed)" ) );
+		UE_LOG( LogSimpleINI, Display, TEXT( "SimpleINI.Benchmark %.1f MB: document %.1f MB, compact %.1f MB (load %.1f MB/s, lookup p50 %.0f ns)" ),
+			MB, Ini.GetAllocatedSize( ) / (1024.0 * 1024.0), CompactIni.GetAllocatedSize( ) / (1024.0 * 1024.0),
+			MB / FMath::Max( CompactLoadSeconds, 1e-9 ), Percentile( CompactLatencies, 0.5 ) );
+
+		return FString::Printf( TEXT( "{\"file_bytes\":%lld,\"sections\":%d,\"keys_per_section\":%d,\"comment_every\":%d,\"value_len\":%d,"
+			"\"load_seconds\":%.6f,\"load_mb_per_s\":%.3f,\"lookups\":%d,\"lookups_found\":%d,"
+			"\"lookup_ns_p50\":%.1f,\"lookup_ns_p90\":%.1f,\"lookup_ns_p99\":%.1f,\"lookup_ns_max\":%.1f,"
+			"\"set_ns_mean\":%.1f,\"save_seconds\":%.6f,\"save_mb_per_s\":%.3f,\"saved\":%s,"
+			"\"document_bytes\":%llu,\"load_used_physical_bytes\":%lld,\"peak_used_physical_bytes\":%llu,"
+			"\"compact_document_bytes\":%llu,\"compact_load_seconds\":%.6f,\"compact_lookup_ns_p50\":%.1f,\"compact_lookup_ns_p99\":%.1f}" ),
+			FileBytes, NumSections, Spec.KeysPerSection, Spec.CommentEvery, Spec.ValueLen,
+			LoadSeconds, MB / FMath::Max( LoadSeconds, 1e-9 ), NumLookups, NumFound,
+			Percentile( Latencies, 0.5 ), Percentile( Latencies, 0.9 ), Percentile( Latencies, 0.99 ), Latencies.Num( ) > 0 ? Latencies.Last( ) : 0.0,
+			SetSeconds / 1000 * 1e9, SaveSeconds, MB / FMath::Max( SaveSeconds, 1e-9 ), bSaved ? TEXT( "true" ) : TEXT( "false" ),
+			(uint64)Ini.GetAllocatedSize( ), LoadedBytes, (uint64)Stats.PeakUsedPhysical,
+			(uint64)CompactIni.GetAllocatedSize( ), CompactLoadSeconds, Percentile( CompactLatencies, 0.5 ), Percentile( CompactLatencies, 0.99 ) );
+	}
+
+	void RunBenchmark( const TArray<FString>& Args )
+	{
+		TArray<FString> Sizes = { TEXT( "1K" ), TEXT( "1M" ), TEXT( "64M" ) };
+		FCorpusSpec Spec;
+		Spec.KeysPerSection = 20;
+		Spec.CommentEvery = 10;
+		Spec.ValueLen = 16;
+		int32 NumLookups = 100000;
+		FString OutPath = FPaths::ProjectSavedDir( ) / TEXT( "SimpleINIBench" ) / FString::Printf( TEXT( "results-%s.json" ), *FDateTime::Now( ).ToString( ) );
+
+		for (const FString& Arg : Args)
+		{
+			FString Key;
+			FString Value;
+			if (!Arg.Split( TEXT( "=" ), &Key, &Value ))
+			{
+				UE_LOG( LogSimpleINI, Display, TEXT( "Usage: SimpleINI.Benchmark [sizes=1K,1M,64M] [keys=20] [comments=10] [value=16] [lookups=100000] [out=<file.json>]" ) );
+				return;
+			}
+			if (Key == TEXT( "sizes" ))
+			{
+				Value.ParseIntoArray( Sizes, TEXT( "," ) );
+			}
+			else if (Key == TEXT( "keys" ))
+			{
+				Spec.KeysPerSection = FMath::Max( 1, FCString::Atoi( *Value ) );
+			}
+			else if (Key == TEXT( "comments" ))
+			{
+				Spec.CommentEvery = FMath::Max( 0, FCString::Atoi( *Value ) );
+			}
+			else if (Key == TEXT( "value" ))
+			{
+				Spec.ValueLen = FMath::Max( 0, FCString::Atoi( *Value ) );
+			}
+			else if (Key == TEXT( "lookups" ))
+			{
+				NumLookups = FMath::Max( 1, FCString::Atoi( *Value ) );
+			}
+			else if (Key == TEXT( "out" ))
+			{
+				OutPath = Value;
+			}
+		}
+
+		const FString CorpusPath = FPaths::GetPath( OutPath ) / TEXT( "corpus.ini" );
+		TArray<FString> Results;
+		for (const FString& Size : Sizes)
+		{
+			Spec.Bytes = ParseSize( Size );
+			const FString Result = RunCorpusBenchmark( CorpusPath, Spec, NumLookups );
+			if (!Result.IsEmpty( ))
+			{
+				Results.Add( Result );
+			}
+		}
+		IFileManager::Get( ).Delete( *CorpusPath, false, false, true );
+
+		const FString Json = FString::Printf( TEXT( "{\"platform\":\"%s\",\"build\":\"%s\",\"results\":[\n%s\n]}\n" ),
+			ANSI_TO_TCHAR( FPlatformProperties::PlatformName( ) ), LexToString( FApp::GetBuildConfiguration( ) ), *FString::Join( Results, TEXT( ",\n" ) ) );
+		if (FFileHelper::SaveStringToFile( Json, *OutPath ))
+		{
+			UE_LOG( LogSimpleINI, Display, TEXT( "SimpleINI.Benchmark: results written to %s" ), *OutPath );
+		}
+		else
+		{
+			UE_LOG( LogSimpleINI, Error, TEXT( "SimpleINI.Benchmark: cannot write %s" ), *OutPath );
+		}
+	}
+
+	FAutoConsoleCommand BenchmarkCommand(
+		TEXT( "SimpleINI.Benchmark" ),
+		TEXT( "Generates synthetic ini files and measures load, lookup, SetValue and save; results go to a JSON file. Usage: SimpleINI.Benchmark [sizes=1K,1M,64M] [keys=20] [comments=10] [value=16] [lookups=100000] [out=<file.json>]" ),
+		FConsoleCommandWithArgsDelegate::CreateStatic( &RunBenchmark ) );
+}
+
+#endif
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+// "stat SimpleINI" in game; the cycle stats also show up as Insights timing events
+DECLARE_STATS_GROUP( TEXT( "SimpleINI" ), STATGROUP_SimpleINI, STATCAT_Advanced );
+
+DECLARE_CYCLE_STAT_EXTERN( TEXT( "Load" ), STAT_IniLoad, STATGROUP_SimpleINI, );
+DECLARE_CYCLE_STAT_EXTERN( TEXT( "Parse" ), STAT_IniParse, STATGROUP_SimpleINI, );
+DECLARE_CYCLE_STAT_EXTERN( TEXT( "Parse Section" ), STAT_IniParseSection, STATGROUP_SimpleINI, );
+DECLARE_CYCLE_STAT_EXTERN( TEXT( "Build Index" ), STAT_IniBuildIndex, STATGROUP_SimpleINI, );
+DECLARE_CYCLE_STAT_EXTERN( TEXT( "Save" ), STAT_IniSave, STATGROUP_SimpleINI, );
+
+DECLARE_DWORD_COUNTER_STAT_EXTERN( TEXT( "Bytes Read" ), STAT_IniBytesRead, STATGROUP_SimpleINI, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN( TEXT( "Bytes Written" ), STAT_IniBytesWritten, STATGROUP_SimpleINI, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN( TEXT( "Lines Parsed" ), STAT_IniLinesParsed, STATGROUP_SimpleINI, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN( TEXT( "Index Buckets Built" ), STAT_IniIndexBuckets, STATGROUP_SimpleINI, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN( TEXT( "Lookup Hits" ), STAT_IniLookupHits, STATGROUP_SimpleINI, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN( TEXT( "Lookup Misses" ), STAT_IniLookupMisses, STATGROUP_SimpleINI, );
+DECLARE_MEMORY_STAT_EXTERN( TEXT( "Documents" ), STAT_IniDocumentMemory, STATGROUP_SimpleINI, );
+// how often and by how much documents outgrew their allocations, through loads and SetValue
+DECLARE_DWORD_COUNTER_STAT_EXTERN( TEXT( "Document Growths" ), STAT_IniDocumentGrowths, STATGROUP_SimpleINI, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN( TEXT( "Document Bytes Grown" ), STAT_IniDocumentBytesGrown, STATGROUP_SimpleINI, );
@@ -1,513 +1,2691 @@
 #include "ini.h"
+#include "SimpleINI.h"
+#include "IniScanner.h"
+#include "IniNameTable.h"
+#include "IniStructBinder.h"
+#include "SimpleINIStats.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFilemanager.h"
+#include "GenericPlatform/GenericPlatformFile.h"
+#include "Async/MappedFileHandle.h"
+#include "Async/ParallelFor.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Misc/FileHelper.h"
+#include "Misc/ScopeRWLock.h"
 
-bool IniFile::LoadFile( const FString& FilePath, bool ClearContent /*= false*/ )
+namespace
 {
-	RawLines.Empty( );
-	Root = nullptr;
+	const TCHAR* const VirtualSectionName = TEXT( "##VirtualSection##" );
 
-	mFilePath = FilePath;
-	if (ClearContent)
-	{
-		return Parse( );
-	}
-	else
+	bool IsVirtualSectionName( FStringView SectionName )
 	{
-		return FFileHelper::LoadFileToStringArray( RawLines, *FilePath ) && Parse( );
+		const int32 VirtualLen = FCString::Strlen( VirtualSectionName );
+		return SectionName.Len( ) == 0
+			|| (SectionName.Len( ) == VirtualLen && FCString::Strnicmp( SectionName.GetData( ), VirtualSectionName, VirtualLen ) == 0);
 	}
-}
 
-bool IniFile::Parse( )
-{
-	TSharedPtr<IniLineContext> Context( new IniLineContext( ) );
-	Context->RawLines = &RawLines;
-	Context->LineNo = 0;
+	// texts from this many characters up are parsed on several threads
+	const int32 ParallelParseMinChars = 1024 * 1024;
 
-	Root = IniRoot::FromLineString( Context );
-	if (Root)
-	{
-		Root->BuildIndex( );
-		return true;
-	}
-	else
+	int32 GetBucketCount( int32 Num )
 	{
-		return false;
+		return (int32)FMath::RoundUpToPowerOfTwo( (uint32)FMath::Max( Num, 16 ) );
 	}
-}
 
-bool IniFile::Save( )
-{
-	if (Root && Root->Lines.Num() > 0)
+	int32 GetUtf8Length( const TCHAR* Str, int32 Len )
 	{
-		RawLines.Empty( );
-		for (int i = 0; i < Root->Lines.Num( ); ++i)
+		int32 Bytes = 0;
+		for (int32 i = 0; i < Len; ++i)
 		{
-			TSharedPtr<IniSection>& Section = Root->Lines[i];
-			if (Section->SectionName)
+			const uint32 C = (uint32)Str[i];
+			if (C < 0x80)
 			{
-				RawLines.Add( Section->SectionName->Raw );
+				Bytes += 1;
 			}
-
-			TSharedPtr<IniSectionContent>& SectionContent = Section->Content;
-			if (SectionContent)
+			else if (C < 0x800)
 			{
-				for (int j = 0; j < SectionContent->Entries.Num( ); ++j)
-				{
-					TSharedPtr<IniSectionContentEntry>& SectionEntry = SectionContent->Entries[j];
-					if (SectionEntry)
-					{
-						switch (SectionEntry->SubType)
-						{
-						case eWhiteLine:
-							RawLines.Add( SectionEntry->Value.WhiteLine->Raw );
-							break;
-						case eComment:
-							RawLines.Add( SectionEntry->Value.Comment->Raw );
-							break;
-						case eOnlyName:
-							RawLines.Add( SectionEntry->Value.OnlyName->Raw );
-							break;
-						case eNameValuePair:
-							RawLines.Add( SectionEntry->Value.NVPair->Raw );
-							break;
-						default:
-							break;
-						}
-					}
-				}
+				Bytes += 2;
+			}
+			else if (C >= 0xD800 && C <= 0xDBFF && i + 1 < Len && (uint32)Str[i + 1] >= 0xDC00 && (uint32)Str[i + 1] <= 0xDFFF)
+			{
+				// surrogate pair
+				Bytes += 4;
+				++i;
+			}
+			else
+			{
+				Bytes += (C < 0x10000) ? 3 : 4;
 			}
 		}
-		if (RawLines.Num( ) > 0)
-		{
-			return FFileHelper::SaveStringArrayToFile( RawLines, *mFilePath );
-		}
+		return Bytes;
 	}
 
-	return false;
-}
-
-bool IniFile::SectionExists( const FString& SectionName ) const
-{
-	if (Root)
-	{
-		return Root->SectionIndexLevel.Find( SectionName ) != nullptr;
-	}
-	else
+	int32 GetUtf8Length( const IniRoot& Root, IniStringRef Ref )
 	{
-		return false;
+		return Root.IsUtf8( ) ? Ref.Len : GetUtf8Length( Root.GetChars( Ref ), Ref.Len );
 	}
-}
 
-bool IniFile::NameExists( const FString& SectionName, const FString& Name ) const
-{
-	if (Root)
+	// copies the text of a line to the end of NewText; the slices of the line move with it
+	template <typename CharType>
+	void MoveLine( TArray<CharType>& NewText, const TArray<CharType>& OldText, IniStringRef& Raw, IniStringRef& Name, IniStringRef& Value )
 	{
-		FString SearchSectionName = SectionName;
-		if (SectionName.IsEmpty( ))
-		{
-			SearchSectionName = TEXT( "##VirtualSection##" );
-		}
-		TSharedPtr<IniLine>* Val = Root->SectionIndexLevel.Find( SearchSectionName );
-		if (Val != nullptr)
+		if (Raw.Len == 0)
 		{
-			TSharedPtr<IniSection> Section = StaticCastSharedPtr<IniSection>( *Val );
-			return Section && (Section->NameIndexLevel.Find( Name ) != nullptr);
+			return;
 		}
-		else
+		const int32 Delta = NewText.Num( ) - Raw.Offset;
+		for (IniStringRef* Slice : { &Name, &Value })
 		{
-			return false;
+			if (Slice->Offset >= Raw.Offset && Slice->Offset + Slice->Len <= Raw.Offset + Raw.Len)
+			{
+				Slice->Offset += Delta;
+			}
 		}
+		NewText.Append( OldText.GetData( ) + Raw.Offset, Raw.Len );
+		Raw.Offset += Delta;
 	}
-	else
-	{
-		return false;
-	}
-}
-
-bool IniFile::GetValue( const FString& SectionName, const FString& Name, FString& Val, bool& IsValid ) const
-{
-	IsValid = false;
 
-	if (Root)
+	// appends the text of Ref as UTF-8, returns its byte count
+	int32 AppendUtf8( const IniRoot& Root, IniStringRef Ref, TArray<uint8>& Out )
 	{
-		FString SearchSectionName = SectionName;
-		if (SectionName.IsEmpty( ))
+		if (Root.IsUtf8( ))
 		{
-			SearchSectionName = TEXT( "##VirtualSection##" );
+			Out.Append( (const uint8*)Root.GetUtf8Chars( Ref ), Ref.Len );
+			return Ref.Len;
 		}
-		TSharedPtr<IniLine>* SectionPtr = Root->SectionIndexLevel.Find( SearchSectionName );
-		if (SectionPtr != nullptr)
+		const FTCHARToUTF8 Converted( Root.GetChars( Ref ), Ref.Len );
+		Out.Append( (const uint8*)Converted.Get( ), Converted.Length( ) );
+		return Converted.Length( );
+	}
+
+	// Calls Visit( Raw, File ) for every line of the document in file order
+	template <typename FunctorType>
+	void ForEachLine( IniRoot& Root, FunctorType Visit )
+	{
+		for (int i = 0; i < Root.Sections.Num( ); ++i)
 		{
-			TSharedPtr<IniSection> Section = StaticCastSharedPtr<IniSection>( *SectionPtr );
-			if (Section)
+			IniSection& Section = Root.Sections[i];
+			if (!Section.IsVirtual)
 			{
-				TSharedPtr<IniLine>* EntryPtr = Section->NameIndexLevel.Find( Name );
-				if (EntryPtr)
-				{
-					TSharedPtr<IniSectionContentEntry> SectionEntry = StaticCastSharedPtr<IniSectionContentEntry>( *EntryPtr );
-					if (SectionEntry->SubType == eOnlyName)
-					{
-						IsValid = false;
-						return true;
-					}
-					else
-					{
-						IsValid = true;
-						Val = SectionEntry->Value.NVPair->Value;
-						return true;
-					}
-				}
-				else
-				{
-					return false;
-				}
+				Visit( Section.Raw, Section.File );
 			}
-			else
+			for (int32 EntryIndex = Section.FirstEntry; EntryIndex != INDEX_NONE; EntryIndex = Root.Entries[EntryIndex].Next)
 			{
-				return false;
+				IniSectionContentEntry& Entry = Root.Entries[EntryIndex];
+				Visit( Entry.Raw, Entry.File );
 			}
 		}
-		else
-		{
-			return false;
-		}
-	}
-	else
-	{
-		return false;
 	}
-}
 
-bool IniFile::SetValue( const FString& SectionName, const FString& Name, const FString& Val )
-{
-	if (Root)
+	// Encodes lines to UTF-8 into a reused buffer and hands it to the sink whenever it
+	// fills up, so writing a document makes no copy of its text
+	class FUtf8LineWriter
 	{
-		FString SearchSectionName = SectionName;
-		if (SectionName.IsEmpty( ))
+	public:
+		typedef TFunctionRef<bool( const uint8* Data, int32 Len )> FSink;
+
+		explicit FUtf8LineWriter( FSink InSink )
+			: Sink( InSink )
+			, Used( 0 )
+			, Flushed( 0 )
+			, bError( false )
 		{
-			SearchSectionName = TEXT( "##VirtualSection##" );
+			Buffer.SetNumUninitialized( BufferSize );
 		}
-		TSharedPtr<IniLine>* SectionPtr = Root->SectionIndexLevel.Find( SearchSectionName );
-		if (SectionPtr != nullptr)
+
+		// appends the line and LINE_TERMINATOR, returns the bytes of the line alone;
+		// encodes exactly what GetUtf8Length counts
+		int32 WriteLine( const TCHAR* Str, int32 Len )
 		{
-			TSharedPtr<IniSection> Section = StaticCastSharedPtr<IniSection>( *SectionPtr );
-			if (Section)
+			const int64 LineStart = Tell( );
+			for (int32 i = 0; i < Len; ++i)
 			{
-				TSharedPtr<IniLine>* EntryPtr = Section->NameIndexLevel.Find( Name );
-				if (EntryPtr)
+				if (Used + 4 > BufferSize)
+				{
+					Flush( );
+				}
+				uint8* Out = Buffer.GetData( ) + Used;
+				uint32 C = (uint32)Str[i];
+				if (C < 0x80)
+				{
+					Out[0] = (uint8)C;
+					Used += 1;
+					continue;
+				}
+				if (C < 0x800)
+				{
+					Out[0] = (uint8)(0xC0 | (C >> 6));
+					Out[1] = (uint8)(0x80 | (C & 0x3F));
+					Used += 2;
+					continue;
+				}
+				if (C >= 0xD800 && C <= 0xDBFF && i + 1 < Len && (uint32)Str[i + 1] >= 0xDC00 && (uint32)Str[i + 1] <= 0xDFFF)
+				{
+					C = 0x10000 + ((C - 0xD800) << 10) + ((uint32)Str[i + 1] - 0xDC00);
+					++i;
+				}
+				if (C < 0x10000)
 				{
-					TSharedPtr<IniSectionContentEntry> SectionEntry = StaticCastSharedPtr<IniSectionContentEntry>( *EntryPtr );
-					if (SectionEntry->SubType == eOnlyName)
-					{
-						SectionEntry->SubType = eNameValuePair;
-						SectionEntry->Value.OnlyName = nullptr;
-						SectionEntry->Value.NVPair = TSharedPtr<IniNameValuePair>( new IniNameValuePair( ) );
-						SectionEntry->Value.NVPair->Name = Name;
-						SectionEntry->Value.NVPair->Value = Val;
-						SectionEntry->Value.NVPair->Raw = Name + TEXT( "=" ) + Val;
-						SectionEntry->Value.NVPair->BelongTo = SectionEntry;
-						return true;
-					}
-					else
-					{
-						SectionEntry->Value.NVPair->Value = Val;
-						SectionEntry->Value.NVPair->Raw = Name + TEXT( "=" ) + Val;
-						return true;
-					}
+					Out[0] = (uint8)(0xE0 | (C >> 12));
+					Out[1] = (uint8)(0x80 | ((C >> 6) & 0x3F));
+					Out[2] = (uint8)(0x80 | (C & 0x3F));
+					Used += 3;
 				}
 				else
 				{
-					TSharedPtr<IniSectionContentEntry> SectionEntry( new IniSectionContentEntry( ) );
-					SectionEntry->BelongTo = Section;
-					SectionEntry->SubType = eNameValuePair;
-					SectionEntry->Value.NVPair = TSharedPtr<IniNameValuePair>( new IniNameValuePair( ) );
-					SectionEntry->Value.NVPair->Name = Name;
-					SectionEntry->Value.NVPair->Value = Val;
-					SectionEntry->Value.NVPair->Raw = Name + TEXT( "=" ) + Val;
-					SectionEntry->Value.NVPair->BelongTo = SectionEntry;
-
-					// add new item
-					Section->Content->Entries.Add( SectionEntry );
-					// update index
-					Section->NameIndexLevel.Add( Name, StaticCastSharedPtr<IniLine>( SectionEntry ) );
-					return true;
+					Out[0] = (uint8)(0xF0 | (C >> 18));
+					Out[1] = (uint8)(0x80 | ((C >> 12) & 0x3F));
+					Out[2] = (uint8)(0x80 | ((C >> 6) & 0x3F));
+					Out[3] = (uint8)(0x80 | (C & 0x3F));
+					Used += 4;
 				}
 			}
-			else
+			const int32 LineBytes = (int32)(Tell( ) - LineStart);
+			WriteTerminator( );
+			return LineBytes;
+		}
+
+		// same for text that is UTF-8 already
+		int32 WriteUtf8Line( const ANSICHAR* Str, int32 Len )
+		{
+			for (int32 Copied = 0; Copied < Len; )
 			{
-				return false;
+				if (Used == BufferSize)
+				{
+					Flush( );
+				}
+				const int32 Count = FMath::Min( Len - Copied, BufferSize - Used );
+				FMemory::Memcpy( Buffer.GetData( ) + Used, Str + Copied, Count );
+				Used += Count;
+				Copied += Count;
 			}
+			WriteTerminator( );
+			return Len;
 		}
-		else
+
+		// false once the sink failed
+		bool Flush( )
 		{
-			TArray<FString> StrArr;
-			if (!SectionName.IsEmpty( ))
+			if (Used > 0 && !bError)
 			{
-				StrArr.Add( TEXT( "[" ) + SectionName + TEXT( "]" ) );
+				bError = !Sink( Buffer.GetData( ), Used );
 			}
-			StrArr.Add( Name + TEXT( "=" ) + Val );
-
-			TSharedPtr<IniLineContext> Context( new IniLineContext( ) );
-			Context->RawLines = &StrArr;
-			Context->LineNo = 0;
+			Flushed += Used;
+			Used = 0;
+			return !bError;
+		}
 
-			// Create Section
-			TSharedPtr<IniSection> Section = IniSection::FromLineString( Context );
-			Root->Lines.Add( Section );
+		// bytes written so far, flushed or not
+		int64 Tell( ) const { return Flushed + Used; }
 
-			// Update index
-			Section->BuildIndex( );
-			if (!Section->SectionName)
+	private:
+		void WriteTerminator( )
+		{
+			for (const TCHAR* Terminator = LINE_TERMINATOR; *Terminator; ++Terminator)
 			{
-				Root->SectionIndexLevel.Add( TEXT( "##VirtualSection##" ), Section );
+				if (Used == BufferSize)
+				{
+					Flush( );
+				}
+				Buffer[Used++] = (uint8)*Terminator;
 			}
-			else
+		}
+
+		static const int32 BufferSize = 64 * 1024;
+
+		FSink Sink;
+		TArray<uint8> Buffer;
+		int32 Used;
+		int64 Flushed;
+		bool bError;
+	};
+
+	// Writes every line of Root in file order; with bTrackLayout every line is given the
+	// place it gets in the output. The byte count, or -1 when the sink failed.
+	int64 WriteLines( IniRoot& Root, FUtf8LineWriter::FSink Sink, bool bTrackLayout )
+	{
+		FUtf8LineWriter Writer( Sink );
+		ForEachLine( Root, [&]( const IniStringRef& Raw, IniFileLine& File )
+		{
+			const int64 Offset = Writer.Tell( );
+			const int32 Len = Root.IsUtf8( ) ? Writer.WriteUtf8Line( Root.GetUtf8Chars( Raw ), Raw.Len ) : Writer.WriteLine( Root.GetChars( Raw ), Raw.Len );
+			if (bTrackLayout)
 			{
-				Root->SectionIndexLevel.Add( Section->SectionName->Value, Section );
+				File = IniFileLine( (int32)Offset, Len );
 			}
-			return true;
-		}
+		} );
+		return Writer.Flush( ) ? Writer.Tell( ) : -1;
 	}
-	else
+
+	// copies, so compact documents are read the same way
+	bool SectionToMap( const IniRoot& Root, const FString& SectionName, TMap<FString, FString>& Values )
 	{
-		return false;
+		const int32 SectionIndex = Root.FindSection( SectionName );
+		if (SectionIndex == INDEX_NONE)
+		{
+			return false;
+		}
+
+		const IniSection& Section = Root.Sections[SectionIndex];
+		Values.Reset( );
+		Values.Reserve( Section.NumEntries );
+		for (int32 EntryIndex = Section.FirstEntry; EntryIndex != INDEX_NONE; EntryIndex = Root.Entries[EntryIndex].Next)
+		{
+			const IniSectionContentEntry& Entry = Root.Entries[EntryIndex];
+			if (Entry.SubType == eNameValuePair)
+			{
+				Values.Add( Root.ToString( Entry.Name ), Root.ToString( Entry.Value ) );
+			}
+		}
+		return true;
 	}
-}
 
-bool IniFile::SetValueAndSave( const FString& SectionName, const FString& Name, const FString& Val )
-{
-	bool SetResult = SetValue( SectionName, Name, Val );
-	if (SetResult)
+	bool ValuesToStrings( const IniRoot& Root, const FString& SectionName, const TArray<FString>& Names, TArray<FString>& Values, TArray<bool>& IsValid )
 	{
-		return Save( );
+		Values.Init( FString( ), Names.Num( ) );
+		IsValid.Init( false, Names.Num( ) );
+		const int32 SectionIndex = Root.FindSection( SectionName );
+		if (SectionIndex == INDEX_NONE)
+		{
+			return false;
+		}
+
+		for (int i = 0; i < Names.Num( ); ++i)
+		{
+			const int32 EntryIndex = Root.FindEntry( SectionIndex, Names[i] );
+			if (EntryIndex != INDEX_NONE && Root.Entries[EntryIndex].SubType == eNameValuePair)
+			{
+				Values[i] = Root.ToString( Root.Entries[EntryIndex].Value );
+				IsValid[i] = true;
+			}
+		}
+		return true;
 	}
-	else
+
+	bool ParseVector( const FString& Str, FVector& OutValue )
 	{
-		// no need to save because nothing change
-		return false;
+		if (OutValue.InitFromString( Str ))
+		{
+			return true;
+		}
+
+		TArray<FString> Parts;
+		if (Str.ParseIntoArray( Parts, TEXT( "," ), false ) != 3)
+		{
+			return false;
+		}
+		for (int i = 0; i < 3; ++i)
+		{
+			if (!LexTryParseString( OutValue[i], *Parts[i].TrimStartAndEnd( ) ))
+			{
+				return false;
+			}
+		}
+		return true;
 	}
-}
 
-TSharedPtr<IniRoot> IniRoot::FromLineString( TSharedPtr<IniLineContext>& Context )
-{
-	TSharedPtr<IniRoot> RootIni( new IniRoot( ) );
-	if (Context.IsValid( ))
+	// fills in the Kind member of Typed from the value text
+	void ParseTyped( FStringView Value, uint8 Kind, IniTypedValue& Typed )
 	{
-		int& LineNo = Context->LineNo;
-		while (LineNo < Context->RawLines->Num( ))
+		const FString Str( Value );
+		bool bValid = false;
+		switch (Kind)
 		{
-			TSharedPtr<IniSection> Section = IniSection::FromLineString( Context );
-			if (!Section.IsValid())
+		case IniTypedValue::Int:
+			bValid = LexTryParseString( Typed.IntValue, *Str );
+			break;
+		case IniTypedValue::Float:
+			bValid = LexTryParseString( Typed.FloatValue, *Str );
+			break;
+		case IniTypedValue::Bool:
+			bValid = IniTypedValue::ParseBool( Str, Typed.BoolValue );
+			break;
+		case IniTypedValue::Vector:
+			bValid = ParseVector( Str, Typed.VectorValue );
+			break;
+		case IniTypedValue::Array:
+			Str.ParseIntoArray( Typed.ArrayValue, TEXT( "," ), false );
+			for (int i = 0; i < Typed.ArrayValue.Num( ); ++i)
 			{
-				return nullptr;
+				Typed.ArrayValue[i].TrimStartAndEndInline( );
 			}
-			RootIni->Lines.Add( Section );
+			bValid = true;
+			break;
 		}
-		return MoveTemp( RootIni );
+		Typed.Parsed |= Kind;
+		Typed.Valid |= bValid ? Kind : 0;
 	}
-	else
+
+	// values compare case-sensitively, unlike names
+	bool IsSameValue( FStringView A, FStringView B )
 	{
-		return nullptr;
+		return A.Len( ) == B.Len( ) && FCString::Strncmp( A.GetData( ), B.GetData( ), A.Len( ) ) == 0;
 	}
-}
 
-void IniRoot::BuildIndex( )
-{
-	for (int i = 0; i < Lines.Num( ); ++i)
+	// Calls Visit( SectionIndex, EntryIndex ) for every value a lookup can find; earlier
+	// duplicates of a section or a name are shadowed by later ones
+	template <typename FunctorType>
+	void ForEachVisibleValue( const IniRoot& Root, FunctorType Visit )
 	{
-		TSharedPtr<IniSection>& Section = Lines[i];
-		if (Section && Section->Content)
+		// entries carry the ids of their names, compact documents compare the text; section
+		// names go through FindSection, which also knows the virtual section's names
+		const bool bById = !Root.IsUtf8( );
+		FString Scratch;
+		for (int i = 0; i < Root.Sections.Num( ); ++i)
 		{
-			Section->BuildIndex( );
-			if (!Section->SectionName)
+			const IniSection& Section = Root.Sections[i];
+			if (!Section.IsVirtual && Root.FindSection( Root.GetString( Section.Name, Scratch ) ) != i)
 			{
-				SectionIndexLevel.Add( TEXT( "##VirtualSection##" ), Section );
+				continue;
 			}
-			else
+			for (int32 EntryIndex = Section.FirstEntry; EntryIndex != INDEX_NONE; EntryIndex = Root.Entries[EntryIndex].Next)
 			{
-				SectionIndexLevel.Add( Section->SectionName->Value, Section );
+				const IniSectionContentEntry& Entry = Root.Entries[EntryIndex];
+				if (Entry.SubType == eNameValuePair
+					&& (bById ? Root.FindEntryById( i, Entry.NameHash, Entry.NameId ) : Root.FindEntry( i, Root.GetString( Entry.Name, Scratch ) )) == EntryIndex)
+				{
+					Visit( i, EntryIndex );
+				}
 			}
 		}
 	}
+
+	// the value the same section/name has in Other, INDEX_NONE if it has none
+	int32 FindMatchingValue( const IniRoot& Root, int32 SectionIndex, int32 EntryIndex, const IniRoot& Other )
+	{
+		FString Scratch;
+		const FStringView SectionName = Root.Sections[SectionIndex].IsVirtual ? FStringView( ) : Root.GetString( Root.Sections[SectionIndex].Name, Scratch );
+		const int32 OtherSection = Other.FindSection( SectionName );
+		if (OtherSection == INDEX_NONE)
+		{
+			return INDEX_NONE;
+		}
+		const int32 OtherEntry = Other.FindEntry( OtherSection, Root.GetString( Root.Entries[EntryIndex].Name, Scratch ) );
+		return (OtherEntry != INDEX_NONE && Other.Entries[OtherEntry].SubType == eNameValuePair) ? OtherEntry : INDEX_NONE;
+	}
+
+	bool WriteAt( IFileHandle& Handle, int64 Offset, const uint8* Data, int64 Size )
+	{
+		// also catches handles that ignore Seek because they were opened for appending
+		return Handle.Seek( Offset ) && Handle.Write( Data, Size ) && Handle.Tell( ) == Offset + Size;
+	}
 }
 
-TSharedPtr<IniSection> IniSection::FromLineString( TSharedPtr<IniLineContext>& Context )
+IniFile::~IniFile( )
 {
-	TSharedPtr<IniSection> Section( new IniSection( ) );
-
-	const FString& LineString = (*Context->RawLines)[Context->LineNo];
-	FString TrimedString = LineString.TrimStartAndEnd( );
-	if (LineString.IsEmpty( ) || 
-		TrimedString.IsEmpty( ) ||
-		TrimedString[0] != TEXT('['))
+	if (IniSnapshot* Current = Snapshot.Exchange( nullptr ))
 	{
-		Section->IsVirtual = true;
-		Context->Value.push_back( StaticCastSharedPtr<IniLine>( Section ) );
+		Current->Release( );
+	}
+	for (const TPair<IniSnapshot*, uint32>& Retired : RetiredSnapshots)
+	{
+		Retired.Key->Release( );
+	}
+	DEC_MEMORY_STAT_BY( STAT_IniDocumentMemory, AccountedBytes );
+}
 
-		Section->SectionName = nullptr;
-		Section->Content = IniSectionContent::FromLineString( Context );
+bool IniFile::LoadFile( const FString& FilePath, bool ClearContent /*= false*/, bool bLazy /*= false*/ )
+{
+	double ParseSeconds = 0.0;
+	TSharedPtr<IniRoot> NewRoot = ParseFile( FilePath, ClearContent, ParseSeconds, bLazy, bCompactStorage );
+	return AdoptRoot( FilePath, NewRoot, ParseSeconds );
+}
 
-		Context->Value.pop_back( );
+bool IniFile::LoadFileMapped( const FString& FilePath )
+{
+	SCOPE_CYCLE_COUNTER( STAT_IniLoad );
+	SCOPED_NAMED_EVENT_FSTRING( FilePath, FColor::Turquoise );
+	const double StartTime = FPlatformTime::Seconds( );
+	IniByteSourcePtr Source = IniByteSource::Open( FilePath );
+	if (!Source)
+	{
+		return AdoptRoot( FilePath, nullptr, 0.0, true );
 	}
-	else
-	{ 
-		Section->IsVirtual = false;
-		Context->Value.push_back( StaticCastSharedPtr<IniLine>( Section ) );
-
-		Section->SectionName = IniSectionName::FromLineString( Context );
-		Section->Content = IniSectionContent::FromLineString( Context );
 
-		Context->Value.pop_back( );
+	const uint8* Data = Source->Data;
+	if (Source->Size >= 2 && ((Data[0] == 0xFF && Data[1] == 0xFE) || (Data[0] == 0xFE && Data[1] == 0xFF)))
+	{
+		// UTF-16 cannot be parsed in place, load it the usual way
+		Source.Reset( );
+		double ParseSeconds = 0.0;
+		TSharedPtr<IniRoot> NewRoot = ParseFile( FilePath, false, ParseSeconds );
+		return AdoptRoot( FilePath, NewRoot, ParseSeconds, true );
 	}
 
-	return MoveTemp( Section );
+	const int32 ByteOrderMarkSize = (Source->Size >= 3 && Data[0] == 0xEF && Data[1] == 0xBB && Data[2] == 0xBF) ? 3 : 0;
+	TSharedPtr<IniRoot> NewRoot = IniRoot::FromBytes( Source, ByteOrderMarkSize );
+	return AdoptRoot( FilePath, NewRoot, FPlatformTime::Seconds( ) - StartTime, true );
+}
+
+int32 IniFile::GetNumSections( ) const
+{
+	return Root ? Root->Sections.Num( ) - 1 : 0;
 }
 
+int32 IniFile::GetNumSectionsParsed( ) const
+{
+	// Sections[0] is parsed up front and not counted either way
+	return Root ? Root->Sections.Num( ) - 1 - Root->GetNumPendingSections( ) : 0;
+}
 
-void IniSection::BuildIndex( )
+bool IniFile::IsSectionParsed( const FString& SectionName ) const
 {
-	if (Content.IsValid( ))
+	if (Root && Root->HasPendingSections( ))
 	{
-		for (int i = 0; i < Content->Entries.Num(); ++i)
-		{
-			TSharedPtr<IniSectionContentEntry>& Entry = Content->Entries[i];
-			if (Entry.IsValid( ))
-			{
-				if (Entry->SubType == eOnlyName && Entry->Value.OnlyName.IsValid( ))
-				{
-					NameIndexLevel.Add( Entry->Value.OnlyName->Value );
-				}
-				else if (Entry->SubType == eNameValuePair && Entry->Value.NVPair.IsValid( ))
-				{
-					NameIndexLevel.Add( Entry->Value.NVPair->Name, StaticCastSharedPtr<IniLine>( Entry ) );
-				}
-			}
-		}
+		const int32 SectionIndex = Root->FindSection( SectionName );
+		return SectionIndex == INDEX_NONE || Root->IsSectionParsed( SectionIndex );
 	}
+	return true;
 }
 
-TSharedPtr<IniSectionName> IniSectionName::FromLineString( TSharedPtr<IniLineContext>& Context )
+bool IniFile::ReloadWithChanges( const TSharedPtr<IniRoot>& NewRoot, double ParseSeconds, TArray<IniValueChange>& OutChanges )
 {
-	TSharedPtr<IniSectionName> SectionName( new IniSectionName( ) );
-	SectionName->BelongTo = StaticCastSharedPtr<IniSection>( Context->Value.back( ) );
-	SectionName->Raw = (*Context->RawLines)[Context->LineNo++];
-	SectionName->Value = SectionName->Raw.TrimStartAndEnd( );
-	SectionName->Value = SectionName->Value.Mid( 1, SectionName->Value.Len( ) - 2 ).TrimStartAndEnd( );
-	return MoveTemp( SectionName );
+	OutChanges.Reset( );
+	if (!Root || !NewRoot || bReadOnly || BatchDepth > 0)
+	{
+		return false;
+	}
+
+	// the changes go to the caller, not to the recorded ones
+	const int32 FirstChange = RecordedChanges.Num( );
+	TGuardValue<bool> RecordGuard( bRecordChanges, true );
+	const bool bAdopted = AdoptRoot( mFilePath, NewRoot, ParseSeconds );
+	OutChanges.Append( RecordedChanges.GetData( ) + FirstChange, RecordedChanges.Num( ) - FirstChange );
+	RecordedChanges.SetNum( FirstChange );
+	return bAdopted;
 }
 
-TSharedPtr<IniSectionContent> IniSectionContent::FromLineString( TSharedPtr<IniLineContext>& Context )
+void IniFile::SetRecordChanges( bool bEnable )
 {
-	TSharedPtr<IniSectionContent> SectionContent( new IniSectionContent( ) );
-	SectionContent->BelongTo = StaticCastSharedPtr<IniSection>( Context->Value.back( ) );
-
-	while (Context->LineNo < Context->RawLines->Num( ))
+	bRecordChanges = bEnable;
+	if (!bEnable && BatchDepth == 0)
 	{
-		TSharedPtr<IniSectionContentEntry> ContentEntry( new IniSectionContentEntry( ) );
-		ContentEntry->BelongTo = StaticCastSharedPtr<IniSection>( Context->Value.back( ) );
-		Context->Value.push_back( StaticCastSharedPtr<IniLine>( ContentEntry ) );
+		RecordedChanges.Empty( );
+	}
+}
 
-		const FString& LineString = (*Context->RawLines)[Context->LineNo];
-		FString TrimedString = LineString.TrimStartAndEnd( );
+void IniFile::TakeChanges( TArray<IniValueChange>& OutChanges )
+{
+	if (BatchDepth == 0)
+	{
+		OutChanges.Append( MoveTemp( RecordedChanges ) );
+		RecordedChanges.Reset( );
+	}
+}
 
-		if (TrimedString.IsEmpty( ))
-		{
-			ContentEntry->SubType = eWhiteLine;
-			ContentEntry->Value.WhiteLine = IniWhiteLine::FromLineString( Context );
-		}
-		else if (TrimedString[0] == TEXT( '#' )
-			|| TrimedString.Find( TEXT( "//" ) ) == 0)
-		{
-			// comment starts with # or //
-			ContentEntry->SubType = eComment;
-			ContentEntry->Value.Comment = IniComment::FromLineString( Context );
-		}
-		else if (TrimedString.Find( TEXT( "=" ) ) > 0)
-		{
-			ContentEntry->SubType = eNameValuePair;
-			ContentEntry->Value.NVPair = IniNameValuePair::FromLineString( Context );
-		}
-		else if (TrimedString[0] != TEXT( '[' ))
-		{
-			ContentEntry->SubType = eOnlyName;
-			ContentEntry->Value.OnlyName = IniOnlyName::FromLineString( Context );
-		}
-		else
+void IniFile::RecordChange( int32 SectionIndex, int32 EntryIndex, const FString& Name, const FString& Val )
+{
+	IniValueChange Change;
+	if (EntryIndex != INDEX_NONE && Root->Entries[EntryIndex].SubType == eNameValuePair)
+	{
+		FString Scratch;
+		const FStringView OldValue = Root->GetString( Root->Entries[EntryIndex].Value, Scratch );
+		if (IsSameValue( OldValue, Val ))
 		{
-			Context->Value.pop_back( ); // pop ContentEntry
-			return MoveTemp( SectionContent );
+			return;
 		}
-
-		Context->Value.pop_back( ); // pop ContentEntry
-		SectionContent->Entries.Add( ContentEntry );
+		Change.OldValue = FString( OldValue );
 	}
-
-	return MoveTemp( SectionContent );
+	else
+	{
+		Change.bAdded = true;
+	}
+	Change.SectionName = Root->ToString( Root->Sections[SectionIndex].Name );
+	Change.Name = Name;
+	Change.NewValue = Val;
+	RecordedChanges.Add( MoveTemp( Change ) );
 }
 
-TSharedPtr<IniWhiteLine> IniWhiteLine::FromLineString( TSharedPtr<IniLineContext>& Context )
+void IniFile::ParsePendingSection( FStringView SectionName ) const
 {
-	TSharedPtr<IniWhiteLine> WhiteLine( new IniWhiteLine( ) );
-	WhiteLine->BelongTo = StaticCastSharedPtr<IniSectionContentEntry>( Context->Value.back( ) );
-	WhiteLine->Raw = (*Context->RawLines)[Context->LineNo++];
-	return MoveTemp( WhiteLine );
+	if (Root && Root->HasPendingSections( ))
+	{
+		const int32 SectionIndex = Root->FindSection( SectionName );
+		if (SectionIndex != INDEX_NONE && !Root->IsSectionParsed( SectionIndex ))
+		{
+			Root->ParseSection( SectionIndex );
+		}
+	}
 }
 
-TSharedPtr<IniComment> IniComment::FromLineString( TSharedPtr<IniLineContext>& Context )
+TSharedPtr<IniRoot> IniFile::ParseFile( const FString& FilePath, bool ClearContent, double& OutParseSeconds, bool bLazy /*= false*/, bool bCompact /*= false*/ )
 {
-	TSharedPtr<IniComment> Comment( new IniComment( ) );
-	Comment->BelongTo = StaticCastSharedPtr<IniSectionContentEntry>( Context->Value.back( ) );
+	SCOPE_CYCLE_COUNTER( STAT_IniLoad );
+	SCOPED_NAMED_EVENT_FSTRING( FilePath, FColor::Turquoise );
 
-	const FString& LineString = (*Context->RawLines)[Context->LineNo++];
-	FString TrimedString = LineString.TrimStartAndEnd( );
-
-	Comment->Raw = LineString;
-	if (TrimedString[0] == TEXT( '#' ))
+	TArray<uint8> Bytes;
+	if (!ClearContent && !FFileHelper::LoadFileToArray( Bytes, *FilePath ))
 	{
-		Comment->Value = TrimedString.Mid( 1 ).TrimStart( );
+		return nullptr;
 	}
-	else
+	INC_DWORD_STAT_BY( STAT_IniBytesRead, Bytes.Num( ) );
+
+	TSharedPtr<IniRoot> NewRoot = bCompact ? ParseBytesCompact( MoveTemp( Bytes ), OutParseSeconds ) : ParseBytes( Bytes, OutParseSeconds, bLazy );
+	if (NewRoot && NewRoot->bFileLayoutKnown)
 	{
-		Comment->Value = TrimedString.Mid( 2 ).TrimStart( );
+		NewRoot->bFileLayoutKnown = !ClearContent;
+		NewRoot->FileTimeStamp = IFileManager::Get( ).GetTimeStamp( *FilePath );
 	}
-
-	return MoveTemp( Comment );
+	return NewRoot;
 }
 
-TSharedPtr<IniOnlyName> IniOnlyName::FromLineString( TSharedPtr<IniLineContext>& Context )
+TSharedPtr<IniRoot> IniFile::ParseBytes( const TArray<uint8>& Bytes, double& OutParseSeconds, bool bLazy /*= false*/ )
 {
-	TSharedPtr<IniOnlyName> OnlyName( new IniOnlyName( ) );
-	OnlyName->BelongTo = StaticCastSharedPtr<IniSectionContentEntry>( Context->Value.back( ) );
+	SCOPE_CYCLE_COUNTER( STAT_IniParse );
+
+	FString Text;
+	FFileHelper::BufferToString( Text, Bytes.GetData( ), Bytes.Num( ) );
 
-	const FString& LineString = (*Context->RawLines)[Context->LineNo++];
-	FString TrimedString = LineString.TrimStartAndEnd( );
+	const bool bUTF16 = Bytes.Num( ) >= 2
+		&& ((Bytes[0] == 0xFF && Bytes[1] == 0xFE) || (Bytes[0] == 0xFE && Bytes[1] == 0xFF));
+	const int32 ByteOrderMarkSize = (Bytes.Num( ) >= 3 && Bytes[0] == 0xEF && Bytes[1] == 0xBB && Bytes[2] == 0xBF) ? 3 : 0;
+	// one byte per character, so character offsets are byte offsets
+	const bool bFileLayoutKnown = !bUTF16 && Bytes.Num( ) - ByteOrderMarkSize == Text.Len( );
 
-	OnlyName->Raw = LineString;
-	OnlyName->Value = TrimedString;
+	// large texts are split at section headers and parsed on several threads
+	const bool bParallel = !bLazy && Text.Len( ) >= ParallelParseMinChars;
 
-	return MoveTemp( OnlyName );
+	const double StartTime = FPlatformTime::Seconds( );
+	TSharedPtr<IniRoot> NewRoot = (bLazy || bParallel)
+		? IniRoot::FromBufferLazy( MoveTemp( Text.GetCharArray( ) ), ByteOrderMarkSize )
+		: IniRoot::FromBuffer( MoveTemp( Text.GetCharArray( ) ), ByteOrderMarkSize );
+	if (NewRoot)
+	{
+		if (bParallel)
+		{
+			NewRoot->ParseAllSectionsParallel( );
+		}
+		else if (!bLazy)
+		{
+			NewRoot->BuildIndex( );
+		}
+		NewRoot->bFileLayoutKnown = bFileLayoutKnown;
+		NewRoot->FileSize = bFileLayoutKnown ? Bytes.Num( ) : 0;
+		NewRoot->SourceBytes = Bytes.Num( );
+	}
+	OutParseSeconds = FPlatformTime::Seconds( ) - StartTime;
+	return NewRoot;
 }
 
-TSharedPtr<IniNameValuePair> IniNameValuePair::FromLineString( TSharedPtr<IniLineContext>& Context )
+TSharedPtr<IniRoot> IniFile::ParseBytesCompact( TArray<uint8>&& Bytes, double& OutParseSeconds )
 {
-	TSharedPtr<IniNameValuePair> NVPair( new IniNameValuePair( ) );
-	NVPair->BelongTo = StaticCastSharedPtr<IniSectionContentEntry>( Context->Value.back( ) );
+	if (Bytes.Num( ) >= 2 && ((Bytes[0] == 0xFF && Bytes[1] == 0xFE) || (Bytes[0] == 0xFE && Bytes[1] == 0xFF)))
+	{
+		return ParseBytes( Bytes, OutParseSeconds );
+	}
 
-	const FString& LineString = (*Context->RawLines)[Context->LineNo++];
-	FString TrimedString = LineString.TrimStartAndEnd( );
+	SCOPE_CYCLE_COUNTER( STAT_IniParse );
+	const int64 NumBytes = Bytes.Num( );
+	const int32 ByteOrderMarkSize = (Bytes.Num( ) >= 3 && Bytes[0] == 0xEF && Bytes[1] == 0xBB && Bytes[2] == 0xBF) ? 3 : 0;
 
-	NVPair->Raw = LineString;
+	const double StartTime = FPlatformTime::Seconds( );
+	TSharedPtr<IniRoot> NewRoot = IniRoot::FromUtf8( MoveTemp( Bytes ), ByteOrderMarkSize );
+	NewRoot->BuildIndex( );
+	// offsets into the text are byte offsets into the file
+	NewRoot->bFileLayoutKnown = true;
+	NewRoot->FileSize = NumBytes;
+	NewRoot->SourceBytes = NumBytes;
+	OutParseSeconds = FPlatformTime::Seconds( ) - StartTime;
+	return NewRoot;
+}
 
-	int Index = TrimedString.Find( TEXT( "=" ) );
-	NVPair->Name = TrimedString.Mid( 0, Index ).TrimEnd( );
+bool IniFile::AdoptRoot( const FString& FilePath, const TSharedPtr<IniRoot>& NewRoot, double ParseSeconds, bool bInReadOnly /*= false*/ )
+{
+	if (BatchDepth > 0)
+	{
+		UE_LOG( LogSimpleINI, Warning, TEXT( "Loading %s drops the open batch" ), *FilePath );
+		BatchDepth = 0;
+		Batch.Reset( );
+	}
 
-	if (Index + 1 == TrimedString.Len( ))
+	// before the comparison below parses every section
+	bLazy = NewRoot && NewRoot->HasPendingSections( );
+	if (bRecordChanges && Root && NewRoot && !bReadOnly && !bInReadOnly)
 	{
-		NVPair->Value = TEXT( "" );
+		Root->ParseAllSections( );
+		NewRoot->ParseAllSections( );
+		IniRoot::Diff( *Root, *NewRoot, RecordedChanges );
 	}
-	else
+
+	mFilePath = FilePath;
+	Root = NewRoot;
+	bUnsavedChanges = false;
+	LastParseSeconds = ParseSeconds;
+	bReadOnly = bInReadOnly;
+	Cache.Reset( );
+	++Generation;
+	++Stats.NumLoads;
+	Stats.BytesRead += Root ? Root->SourceBytes : 0;
+	UpdateMemoryStat( );
+
+	// on failure too: readers must not keep seeing the previous contents
+	if (bSnapshotReads)
 	{
-		NVPair->Value = TrimedString.Mid( Index + 1 ).TrimStart( );
+		PublishSnapshot( );
 	}
 
-	return MoveTemp( NVPair );
+	if (Root)
+	{
+		UE_LOG( LogSimpleINI, Verbose, TEXT( "Parsed %s: %d sections, %d entries, %llu bytes in %.3f ms" ),
+			*mFilePath, Root->Sections.Num( ), Root->Entries.Num( ), (uint64)Root->GetAllocatedSize( ), LastParseSeconds * 1000.0 );
+		return true;
+	}
+	else
+	{
+		return false;
+	}
+}
+
+bool IniFile::Save( )
+{
+	if (Root && !bReadOnly && Root->HasLines( ))
+	{
+		SCOPE_CYCLE_COUNTER( STAT_IniSave );
+		SCOPED_NAMED_EVENT_FSTRING( mFilePath, FColor::Orange );
+		const double StartTime = FPlatformTime::Seconds( );
+
+		Root->ParseAllSections( );
+		const bool bSaved = (CanSaveInPlace( ) && SaveInPlace( )) || SaveWhole( );
+		bUnsavedChanges = bUnsavedChanges && !bSaved;
+		++Stats.NumSaves;
+		Stats.LastSaveSeconds = FPlatformTime::Seconds( ) - StartTime;
+		UpdateMemoryStat( );
+		return bSaved;
+	}
+
+	return false;
+}
+
+bool IniFile::CanSaveInPlace( ) const
+{
+	return Root->bFileLayoutKnown
+		&& IFileManager::Get( ).FileSize( *mFilePath ) == Root->FileSize
+		&& IFileManager::Get( ).GetTimeStamp( *mFilePath ) == Root->FileTimeStamp;
+}
+
+bool IniFile::SaveInPlace( )
+{
+	const FTCHARToUTF8 Terminator( LINE_TERMINATOR );
+
+	// the tail starts at the first line that is new or no longer fits where it was;
+	// everything from there to the end of the file is rewritten
+	int32 LineNo = 0;
+	int32 TailLine = INDEX_NONE;
+	int64 TailStart = 0;
+	ForEachLine( *Root, [&]( const IniStringRef& Raw, IniFileLine& File )
+	{
+		if (TailLine == INDEX_NONE)
+		{
+			if (File.Offset == INDEX_NONE
+				|| (File.bDirty && GetUtf8Length( *Root, Raw ) > File.Len))
+			{
+				TailLine = LineNo;
+			}
+			else
+			{
+				TailStart = File.Offset + File.Len;
+			}
+		}
+		++LineNo;
+	} );
+
+	// changed lines in front of the tail keep their place, padded with blanks that
+	// trimming drops again on the next load
+	struct FPatch
+	{
+		int64 Offset;
+		int32 Start;
+		int32 Len;
+	};
+	TArray<FPatch> Patches;
+	TArray<uint8> Bytes;
+	TArray<uint8> Tail;
+	// where each written line ends up; the lines only take it once every write succeeded,
+	// so a save that fails or falls back to SaveWhole leaves the layout describing the file
+	TArray<TPair<IniFileLine*, IniFileLine>> NewLayout;
+	LineNo = 0;
+	ForEachLine( *Root, [&]( const IniStringRef& Raw, IniFileLine& File )
+	{
+		if (TailLine != INDEX_NONE && LineNo >= TailLine)
+		{
+			// every tail line starts with the terminator of the line in front of it
+			if (TailStart > 0 || LineNo > TailLine)
+			{
+				Tail.Append( (const uint8*)Terminator.Get( ), Terminator.Length( ) );
+			}
+			const int32 LineStart = Tail.Num( );
+			const int32 LineLen = AppendUtf8( *Root, Raw, Tail );
+			NewLayout.Emplace( &File, IniFileLine( (int32)(TailStart + LineStart), LineLen ) );
+		}
+		else if (File.bDirty)
+		{
+			FPatch& Patch = Patches.AddDefaulted_GetRef( );
+			Patch.Offset = File.Offset;
+			Patch.Start = Bytes.Num( );
+			Patch.Len = File.Len;
+			const int32 LineLen = AppendUtf8( *Root, Raw, Bytes );
+			Bytes.AddUninitialized( File.Len - LineLen );
+			FMemory::Memset( Bytes.GetData( ) + Patch.Start + LineLen, ' ', File.Len - LineLen );
+			NewLayout.Emplace( &File, IniFileLine( File.Offset, File.Len ) );
+		}
+		++LineNo;
+	} );
+
+	if (TailLine != INDEX_NONE)
+	{
+		Tail.Append( (const uint8*)Terminator.Get( ), Terminator.Length( ) );
+		if (TailStart + Tail.Num( ) < Root->FileSize)
+		{
+			// the file would have to shrink
+			return false;
+		}
+	}
+	if (Patches.Num( ) == 0 && TailLine == INDEX_NONE)
+	{
+		return true;
+	}
+
+	TUniquePtr<IFileHandle> Handle( FPlatformFileManager::Get( ).GetPlatformFile( ).OpenWrite( *mFilePath, true, true ) );
+	if (!Handle)
+	{
+		return false;
+	}
+	int64 Written = 0;
+	for (int i = 0; i < Patches.Num( ); ++i)
+	{
+		if (!WriteAt( *Handle, Patches[i].Offset, Bytes.GetData( ) + Patches[i].Start, Patches[i].Len ))
+		{
+			return false;
+		}
+		Written += Patches[i].Len;
+	}
+	if (TailLine != INDEX_NONE && !WriteAt( *Handle, TailStart, Tail.GetData( ), Tail.Num( ) ))
+	{
+		return false;
+	}
+	Handle.Reset( );
+	for (const TPair<IniFileLine*, IniFileLine>& Line : NewLayout)
+	{
+		*Line.Key = Line.Value;
+	}
+	Written += (TailLine != INDEX_NONE) ? Tail.Num( ) : 0;
+	Stats.BytesWritten += Written;
+	INC_DWORD_STAT_BY( STAT_IniBytesWritten, Written );
+
+	Root->FileSize = FMath::Max( Root->FileSize, TailStart + Tail.Num( ) );
+	Root->FileTimeStamp = IFileManager::Get( ).GetTimeStamp( *mFilePath );
+	UE_LOG( LogSimpleINI, Verbose, TEXT( "Saved %s in place: %d patched lines, %d tail bytes" ), *mFilePath, Patches.Num( ), Tail.Num( ) );
+	return true;
+}
+
+bool IniFile::SaveWhole( )
+{
+	// write next to the file and rename over it, so a failed save leaves the old file intact
+	const FString TempPath = mFilePath + TEXT( ".tmp" );
+	TUniquePtr<FArchive> Writer( IFileManager::Get( ).CreateFileWriter( *TempPath ) );
+	if (!Writer)
+	{
+		return false;
+	}
+
+	// lines take their new places as they are written, which only describes the file
+	// once it replaced the old one
+	Root->bFileLayoutKnown = false;
+	const int64 Written = WriteLines( *Root, [&Writer]( const uint8* Data, int32 Len )
+	{
+		Writer->Serialize( (void*)Data, Len );
+		return !Writer->IsError( );
+	}, true );
+	const bool bClosed = Writer->Close( );
+	Writer.Reset( );
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get( ).GetPlatformFile( );
+	if (Written < 0 || !bClosed
+		|| (!PlatformFile.MoveFile( *mFilePath, *TempPath ) && !IFileManager::Get( ).Move( *mFilePath, *TempPath, true )))
+	{
+		IFileManager::Get( ).Delete( *TempPath );
+		return false;
+	}
+
+	Root->bFileLayoutKnown = true;
+	Root->FileSize = Written;
+	Root->FileTimeStamp = IFileManager::Get( ).GetTimeStamp( *mFilePath );
+	Stats.BytesWritten += Written;
+	INC_DWORD_STAT_BY( STAT_IniBytesWritten, Written );
+	return true;
+}
+
+bool IniFile::SaveToBytes( TArray<uint8>& OutBytes )
+{
+	OutBytes.Reset( );
+	if (!Root)
+	{
+		return false;
+	}
+
+	Root->ParseAllSections( );
+	return WriteLines( *Root, [&OutBytes]( const uint8* Data, int32 Len )
+	{
+		OutBytes.Append( Data, Len );
+		return true;
+	}, false ) >= 0;
+}
+
+bool IniFile::SaveToArchive( FArchive& Ar )
+{
+	if (!Root || !Ar.IsSaving( ))
+	{
+		return false;
+	}
+
+	Root->ParseAllSections( );
+	return WriteLines( *Root, [&Ar]( const uint8* Data, int32 Len )
+	{
+		Ar.Serialize( (void*)Data, Len );
+		return !Ar.IsError( );
+	}, false ) >= 0;
+}
+
+bool IniFile::SectionExists( const FString& SectionName ) const
+{
+	if (Root)
+	{
+		return Root->FindSection( SectionName ) != INDEX_NONE;
+	}
+	else
+	{
+		return false;
+	}
+}
+
+bool IniFile::NameExists( const FString& SectionName, const FString& Name ) const
+{
+	ParsePendingSection( SectionName );
+	if (Root)
+	{
+		const int32 SectionIndex = Root->FindSection( SectionName );
+		return SectionIndex != INDEX_NONE && Root->FindEntry( SectionIndex, Name ) != INDEX_NONE;
+	}
+	else
+	{
+		return false;
+	}
+}
+
+bool IniFile::GetValue( const FString& SectionName, const FString& Name, FString& Val, bool& IsValid ) const
+{
+	ParsePendingSection( SectionName );
+	IsValid = false;
+	const bool bRet = Root && Root->GetValue( SectionName, Name, Val, IsValid );
+	CountLookup( IsValid );
+	return bRet;
+}
+
+bool IniFile::GetValueView( const FString& SectionName, const FString& Name, FStringView& Val, bool& IsValid ) const
+{
+	ParsePendingSection( SectionName );
+	IsValid = false;
+	const bool bRet = Root && Root->GetValue( SectionName, Name, Val, IsValid );
+	CountLookup( IsValid );
+	return bRet;
+}
+
+bool IniFile::GetSection( const FString& SectionName, TMap<FString, FString>& Values ) const
+{
+	ParsePendingSection( SectionName );
+	return Root && SectionToMap( *Root, SectionName, Values );
+}
+
+bool IniFile::GetStruct( const FString& SectionName, const FIniStructBinder& Binder, void* Data, int32& NumSet ) const
+{
+	NumSet = 0;
+	ParsePendingSection( SectionName );
+	const int32 SectionIndex = Root ? Root->FindSection( SectionName ) : INDEX_NONE;
+	if (SectionIndex == INDEX_NONE)
+	{
+		return false;
+	}
+	NumSet = Binder.Import( *Root, SectionIndex, Data );
+	return true;
+}
+
+bool IniFile::GetSectionView( const FString& SectionName, TArray<TPair<FStringView, FStringView>>& Values ) const
+{
+	ParsePendingSection( SectionName );
+	return Root && Root->GetSectionValues( SectionName, Values );
+}
+
+bool IniFile::GetValues( const FString& SectionName, const TArray<FString>& Names, TArray<FString>& Values, TArray<bool>& IsValid ) const
+{
+	ParsePendingSection( SectionName );
+	if (!Root)
+	{
+		IsValid.Init( false, Names.Num( ) );
+		Values.Init( FString( ), Names.Num( ) );
+		return false;
+	}
+	return ValuesToStrings( *Root, SectionName, Names, Values, IsValid );
+}
+
+void IniFile::GetAllValues( TMap<TPair<FString, FString>, FString>& Values ) const
+{
+	if (!Root)
+	{
+		return;
+	}
+
+	Root->ParseAllSections( );
+	ForEachVisibleValue( *Root, [&]( int32 SectionIndex, int32 EntryIndex )
+	{
+		const IniSectionContentEntry& Entry = Root->Entries[EntryIndex];
+		Values.Add( MakeTuple( Root->ToString( Root->Sections[SectionIndex].Name ), Root->ToString( Entry.Name ) ), Root->ToString( Entry.Value ) );
+	} );
+}
+
+bool IniFile::GetInt( const FString& SectionName, const FString& Name, int32& Val, bool& IsValid ) const
+{
+	ParsePendingSection( SectionName );
+	IsValid = false;
+	const bool bRet = Root && Cache.GetInt( *Root, SectionName, Name, Val, IsValid );
+	CountLookup( IsValid );
+	return bRet;
+}
+
+bool IniFile::GetFloat( const FString& SectionName, const FString& Name, float& Val, bool& IsValid ) const
+{
+	ParsePendingSection( SectionName );
+	IsValid = false;
+	const bool bRet = Root && Cache.GetFloat( *Root, SectionName, Name, Val, IsValid );
+	CountLookup( IsValid );
+	return bRet;
+}
+
+bool IniFile::GetBool( const FString& SectionName, const FString& Name, bool& Val, bool& IsValid ) const
+{
+	ParsePendingSection( SectionName );
+	IsValid = false;
+	const bool bRet = Root && Cache.GetBool( *Root, SectionName, Name, Val, IsValid );
+	CountLookup( IsValid );
+	return bRet;
+}
+
+bool IniFile::GetVector( const FString& SectionName, const FString& Name, FVector& Val, bool& IsValid ) const
+{
+	ParsePendingSection( SectionName );
+	IsValid = false;
+	const bool bRet = Root && Cache.GetVector( *Root, SectionName, Name, Val, IsValid );
+	CountLookup( IsValid );
+	return bRet;
+}
+
+bool IniFile::GetArray( const FString& SectionName, const FString& Name, TArray<FString>& Val, bool& IsValid ) const
+{
+	ParsePendingSection( SectionName );
+	IsValid = false;
+	const bool bRet = Root && Cache.GetArray( *Root, SectionName, Name, Val, IsValid );
+	CountLookup( IsValid );
+	return bRet;
+}
+
+bool IniFile::SetValue( const FString& SectionName, const FString& Name, const FString& Val )
+{
+	if (Root && !bReadOnly)
+	{
+		ApplyValue( SectionName, Name, Val );
+		if (bSnapshotReads && !Batch)
+		{
+			PublishSnapshot( );
+		}
+		return true;
+	}
+	else
+	{
+		return false;
+	}
+}
+
+bool IniFile::SetStruct( const FString& SectionName, const FIniStructBinder& Binder, const void* Data )
+{
+	if (!Root || bReadOnly)
+	{
+		return false;
+	}
+	ParsePendingSection( SectionName );
+
+	TArray<TPair<FString, FString>> Values;
+	Binder.Export( Data, Values );
+	TArray<int32> EntryIndices;
+	const int32 SectionIndex = Root->FindSection( SectionName );
+	if (SectionIndex != INDEX_NONE)
+	{
+		Binder.FindEntries( *Root, SectionIndex, EntryIndices );
+	}
+	else
+	{
+		EntryIndices.Init( INDEX_NONE, Values.Num( ) );
+	}
+
+	bool bChanged = false;
+	FString Scratch;
+	for (int32 i = 0; i < Values.Num( ); ++i)
+	{
+		// values that did not change keep their line and their typed cache
+		const int32 EntryIndex = EntryIndices[i];
+		if (EntryIndex != INDEX_NONE && Root->Entries[EntryIndex].SubType == eNameValuePair
+			&& IsSameValue( Root->GetString( Root->Entries[EntryIndex].Value, Scratch ), Values[i].Value ))
+		{
+			continue;
+		}
+		ApplyValue( SectionName, Values[i].Key, Values[i].Value );
+		bChanged = true;
+	}
+
+	if (bChanged && bSnapshotReads && !Batch)
+	{
+		PublishSnapshot( );
+	}
+	return true;
+}
+
+void IniFile::ApplyValue( const FString& SectionName, const FString& Name, const FString& Val )
+{
+	ParsePendingSection( SectionName );
+
+	int32 SectionIndex = Root->FindSection( SectionName );
+	if (SectionIndex == INDEX_NONE)
+	{
+		SectionIndex = Root->AddSection( SectionName );
+	}
+
+	const int32 EntryIndex = Root->FindEntry( SectionIndex, Name );
+	if (Batch)
+	{
+		// AddEntry links the new entry behind the last one of the section
+		Batch->SaveSection( *Root, SectionIndex );
+		Batch->SaveEntry( *Root, EntryIndex != INDEX_NONE ? EntryIndex : Root->Sections[SectionIndex].LastEntry );
+		Batch->bChanged = true;
+	}
+	if (bRecordChanges)
+	{
+		RecordChange( SectionIndex, EntryIndex, Name, Val );
+	}
+	if (EntryIndex != INDEX_NONE)
+	{
+		Root->SetEntryValue( EntryIndex, Name, Val );
+		Cache.Invalidate( EntryIndex );
+	}
+	else
+	{
+		const int32 NewEntry = Root->AddEntry( SectionIndex, eWhiteLine, IniStringRef( ), IniStringRef( ), IniStringRef( ) );
+		Root->SetEntryValue( NewEntry, Name, Val );
+	}
+	bUnsavedChanges = true;
+	UpdateMemoryStat( );
+}
+
+bool IniFile::SetValueAndSave( const FString& SectionName, const FString& Name, const FString& Val )
+{
+	bool SetResult = SetValue( SectionName, Name, Val );
+	if (SetResult)
+	{
+		return Save( );
+	}
+	else
+	{
+		// no need to save because nothing change
+		return false;
+	}
+}
+
+IniKeyHandle IniFile::MakeKeyHandle( const FString& SectionName, const FString& Name ) const
+{
+	IniKeyHandle Key;
+	Key.SectionName = SectionName;
+	Key.Name = Name;
+	Key.bVirtualSection = IsVirtualSectionName( SectionName );
+	Key.SectionHash = IniRoot::HashName( *SectionName, SectionName.Len( ) );
+	Key.NameHash = IniRoot::HashName( *Name, Name.Len( ) );
+	// names are interned by the documents that have them, a handle only looks them up
+	Key.SectionId = Key.bVirtualSection ? FIniNameTable::NoName : FIniNameTable::Get( ).Find( SectionName, Key.SectionHash );
+	Key.NameId = FIniNameTable::Get( ).Find( Name, Key.NameHash );
+	ResolveKey( Key );
+	return Key;
+}
+
+int32 IniFile::ResolveKey( IniKeyHandle& Key ) const
+{
+	if (!Root)
+	{
+		return INDEX_NONE;
+	}
+	if (Key.Generation == Generation && Key.EntryIndex != INDEX_NONE)
+	{
+		return Key.EntryIndex;
+	}
+
+	// the virtual section may be empty, FindEntry then finds nothing in it; compact
+	// documents do not intern their names and are searched by text
+	const bool bById = !Root->IsUtf8( );
+	if (bById)
+	{
+		// a name no document had when the handle was made may have been added since
+		if (Key.SectionId == FIniNameTable::NoName && !Key.bVirtualSection)
+		{
+			Key.SectionId = FIniNameTable::Get( ).Find( Key.SectionName, Key.SectionHash );
+		}
+		if (Key.NameId == FIniNameTable::NoName)
+		{
+			Key.NameId = FIniNameTable::Get( ).Find( Key.Name, Key.NameHash );
+		}
+	}
+	int32 SectionIndex = 0;
+	if (!Key.bVirtualSection)
+	{
+		SectionIndex = bById ? Root->FindSectionById( Key.SectionHash, Key.SectionId ) : Root->FindSection( Key.SectionName, Key.SectionHash );
+	}
+	if (SectionIndex != INDEX_NONE && !Root->IsSectionParsed( SectionIndex ))
+	{
+		Root->ParseSection( SectionIndex );
+	}
+	if (SectionIndex == INDEX_NONE)
+	{
+		Key.EntryIndex = INDEX_NONE;
+	}
+	else
+	{
+		Key.EntryIndex = bById ? Root->FindEntryById( SectionIndex, Key.NameHash, Key.NameId ) : Root->FindEntry( SectionIndex, Key.Name, Key.NameHash );
+	}
+	Key.Generation = Generation;
+	return Key.EntryIndex;
+}
+
+bool IniFile::GetValue( IniKeyHandle& Key, FString& Val, bool& IsValid ) const
+{
+	IsValid = false;
+	const int32 EntryIndex = ResolveKey( Key );
+	if (EntryIndex == INDEX_NONE)
+	{
+		CountLookup( false );
+		return false;
+	}
+
+	const IniSectionContentEntry& Entry = Root->Entries[EntryIndex];
+	if (Entry.SubType == eNameValuePair)
+	{
+		IsValid = true;
+		Val = Root->ToString( Entry.Value );
+	}
+	CountLookup( IsValid );
+	return true;
+}
+
+bool IniFile::GetValueView( IniKeyHandle& Key, FStringView& Val, bool& IsValid ) const
+{
+	IsValid = false;
+	const int32 EntryIndex = Root ? ResolveKey( Key ) : INDEX_NONE;
+	if (EntryIndex == INDEX_NONE)
+	{
+		CountLookup( false );
+		return false;
+	}
+
+	const IniSectionContentEntry& Entry = Root->Entries[EntryIndex];
+	if (Entry.SubType == eNameValuePair)
+	{
+		IsValid = true;
+		Val = Root->GetView( Entry.Value );
+	}
+	CountLookup( IsValid );
+	return true;
+}
+
+bool IniFile::SetValue( IniKeyHandle& Key, const FString& Val )
+{
+	if (bReadOnly)
+	{
+		return false;
+	}
+
+	const int32 EntryIndex = ResolveKey( Key );
+	if (EntryIndex == INDEX_NONE)
+	{
+		// the handle picks up the new entry on its next use
+		return SetValue( Key.SectionName, Key.Name, Val );
+	}
+
+	if (Batch)
+	{
+		Batch->SaveEntry( *Root, EntryIndex );
+		Batch->bChanged = true;
+	}
+	if (bRecordChanges)
+	{
+		RecordChange( Root->Entries[EntryIndex].Section, EntryIndex, Key.Name, Val );
+	}
+	Root->SetEntryValue( EntryIndex, Key.Name, Val );
+	Cache.Invalidate( EntryIndex );
+	bUnsavedChanges = true;
+	UpdateMemoryStat( );
+
+	if (bSnapshotReads && !Batch)
+	{
+		PublishSnapshot( );
+	}
+	return true;
+}
+
+bool IniFile::BeginBatch( )
+{
+	if (!Root || bReadOnly)
+	{
+		return false;
+	}
+	if (BatchDepth++ == 0)
+	{
+		// the undo log cannot take back sections parsed during the batch
+		Root->ParseAllSections( );
+		Batch.Reset( new IniBatchLog( *Root, RecordedChanges.Num( ), bUnsavedChanges ) );
+		Root->SetBatchOpen( true );
+	}
+	return true;
+}
+
+bool IniFile::CommitBatch( bool bSave /*= true*/ )
+{
+	if (BatchDepth == 0)
+	{
+		return false;
+	}
+	if (--BatchDepth > 0)
+	{
+		return true;
+	}
+
+	Root->SetBatchOpen( false );
+	if (Batch->bChanged && bSave && !Save( ))
+	{
+		UE_LOG( LogSimpleINI, Warning, TEXT( "Saving %s failed, rolling back the batch" ), *mFilePath );
+		Batch->Restore( *Root );
+		RecordedChanges.SetNum( Batch->NumRecordedChanges );
+		Cache.Reset( );
+		++Generation;
+		// the failed save may have moved lines the batch did not touch
+		Root->bFileLayoutKnown = false;
+		Batch.Reset( );
+		return false;
+	}
+
+	const bool bChanged = Batch->bChanged;
+	Batch.Reset( );
+	if (bSnapshotReads && bChanged)
+	{
+		PublishSnapshot( );
+	}
+	return true;
+}
+
+void IniFile::RollbackBatch( )
+{
+	if (BatchDepth == 0)
+	{
+		return;
+	}
+
+	// an inner rollback undoes the whole batch
+	BatchDepth = 0;
+	Batch->Restore( *Root );
+	RecordedChanges.SetNum( Batch->NumRecordedChanges );
+	bUnsavedChanges = Batch->bHadUnsavedChanges;
+	Batch.Reset( );
+	Cache.Reset( );
+	++Generation;
+}
+
+IniFileStats IniFile::GetStats( ) const
+{
+	IniFileStats Result = Stats;
+	Result.LastParseSeconds = LastParseSeconds;
+	Result.LookupHits = LookupHits.GetValue( );
+	Result.LookupMisses = LookupMisses.GetValue( );
+	Result.NumSections = GetNumSections( );
+	Result.NumSectionsParsed = GetNumSectionsParsed( );
+	if (Root)
+	{
+		Result.NumEntries = Root->Entries.Num( );
+		Result.NumChars = Root->GetTextLen( );
+		Result.NumSectionBuckets = Root->SectionIndexLevel.Num( );
+		Result.NumNameBuckets = Root->NameIndexLevel.Num( );
+	}
+	Result.AllocatedBytes = GetAllocatedSize( );
+	return Result;
+}
+
+void IniFile::CountLookup( bool IsValid ) const
+{
+	if (IsValid)
+	{
+		LookupHits.Increment( );
+		INC_DWORD_STAT( STAT_IniLookupHits );
+	}
+	else
+	{
+		LookupMisses.Increment( );
+		INC_DWORD_STAT( STAT_IniLookupMisses );
+	}
+}
+
+void IniFile::UpdateMemoryStat( )
+{
+	const SIZE_T Bytes = GetAllocatedSize( );
+	if (Bytes > AccountedBytes)
+	{
+		++Stats.NumGrowths;
+		Stats.BytesGrown += Bytes - AccountedBytes;
+		INC_DWORD_STAT( STAT_IniDocumentGrowths );
+		INC_DWORD_STAT_BY( STAT_IniDocumentBytesGrown, Bytes - AccountedBytes );
+	}
+	DEC_MEMORY_STAT_BY( STAT_IniDocumentMemory, AccountedBytes );
+	INC_MEMORY_STAT_BY( STAT_IniDocumentMemory, Bytes );
+	AccountedBytes = Bytes;
+}
+
+SIZE_T IniFile::GetAllocatedSize( ) const
+{
+	return (Root ? Root->GetAllocatedSize( ) : 0) + Cache.GetAllocatedSize( );
+}
+
+void IniFile::SetSnapshotReads( bool bEnable )
+{
+	bSnapshotReads = bEnable;
+	PublishSnapshot( );
+}
+
+IniSnapshotRef IniFile::AcquireSnapshot( ) const
+{
+	// Register as a reader of the current epoch before touching the pointer. A
+	// snapshot retired after we registered is only released once every epoch up to
+	// the one it was retired in has no readers left, so the reference below is never
+	// taken on a freed one. The loop only repeats when the epoch moved on in between.
+	uint32 Epoch;
+	for (;;)
+	{
+		Epoch = SnapshotEpoch.Load( );
+		SnapshotReaders[Epoch & 1].Increment( );
+		if (SnapshotEpoch.Load( ) == Epoch)
+		{
+			break;
+		}
+		SnapshotReaders[Epoch & 1].Decrement( );
+	}
+
+	IniSnapshotRef Result( Snapshot.Load( ) );
+	SnapshotReaders[Epoch & 1].Decrement( );
+
+	// the last reader out frees what the writer could not
+	if (NumRetiredSnapshots.GetValue( ) > 0 && RetiredLock.TryLock( ))
+	{
+		ReclaimSnapshots( );
+		RetiredLock.Unlock( );
+	}
+	return Result;
+}
+
+void IniFile::PublishSnapshot( )
+{
+	IniSnapshot* NewSnapshot = nullptr;
+	if (bSnapshotReads && Root)
+	{
+		// snapshots are read without locks, so they cannot parse sections later
+		Root->ParseAllSections( );
+		NewSnapshot = new IniSnapshot( *Root );
+		NewSnapshot->AddRef( );
+	}
+
+	IniSnapshot* OldSnapshot = Snapshot.Exchange( NewSnapshot );
+	FScopeLock ScopeLock( &RetiredLock );
+	if (OldSnapshot)
+	{
+		// any reader registered up to now may still be about to add a reference
+		RetiredSnapshots.Emplace( OldSnapshot, SnapshotEpoch.Load( ) );
+		NumRetiredSnapshots.Increment( );
+	}
+	ReclaimSnapshots( );
+}
+
+void IniFile::ReclaimSnapshots( ) const
+{
+	// Readers of epoch E count in SnapshotReaders[E & 1]. The epoch only moves from E
+	// to E + 1 once the readers of E - 1 are gone, so a counter never mixes the readers
+	// of the current epoch with older ones, and no reader of an epoch before E - 1 is
+	// left. A snapshot retired in epoch T can go once the epoch is past T and the
+	// previous epoch's counter is empty. Nothing here waits.
+	for (int Pass = 0; Pass < 2 && RetiredSnapshots.Num( ) > 0; ++Pass)
+	{
+		const uint32 Epoch = SnapshotEpoch.Load( );
+		if (SnapshotReaders[(Epoch - 1) & 1].GetValue( ) != 0)
+		{
+			return;
+		}
+		for (int i = RetiredSnapshots.Num( ) - 1; i >= 0; --i)
+		{
+			if (RetiredSnapshots[i].Value != Epoch)
+			{
+				RetiredSnapshots[i].Key->Release( );
+				RetiredSnapshots.RemoveAtSwap( i, 1, false );
+				NumRetiredSnapshots.Decrement( );
+			}
+		}
+		if (RetiredSnapshots.Num( ) > 0)
+		{
+			// the ones retired in this epoch wait for its readers in the next
+			SnapshotEpoch.Store( Epoch + 1 );
+		}
+	}
+}
+
+bool IniSnapshot::SectionExists( const FString& SectionName ) const
+{
+	return Root.FindSection( SectionName ) != INDEX_NONE;
+}
+
+bool IniSnapshot::NameExists( const FString& SectionName, const FString& Name ) const
+{
+	const int32 SectionIndex = Root.FindSection( SectionName );
+	return SectionIndex != INDEX_NONE && Root.FindEntry( SectionIndex, Name ) != INDEX_NONE;
+}
+
+bool IniSnapshot::GetValue( const FString& SectionName, const FString& Name, FString& Val, bool& IsValid ) const
+{
+	IsValid = false;
+	return Root.GetValue( SectionName, Name, Val, IsValid );
+}
+
+bool IniSnapshot::GetValueView( const FString& SectionName, const FString& Name, FStringView& Val, bool& IsValid ) const
+{
+	IsValid = false;
+	return Root.GetValue( SectionName, Name, Val, IsValid );
+}
+
+bool IniSnapshot::GetSection( const FString& SectionName, TMap<FString, FString>& Values ) const
+{
+	return SectionToMap( Root, SectionName, Values );
+}
+
+bool IniSnapshot::GetValues( const FString& SectionName, const TArray<FString>& Names, TArray<FString>& Values, TArray<bool>& IsValid ) const
+{
+	return ValuesToStrings( Root, SectionName, Names, Values, IsValid );
+}
+
+bool IniSnapshot::GetStruct( const FString& SectionName, const FIniStructBinder& Binder, void* Data, int32& NumSet ) const
+{
+	NumSet = 0;
+	const int32 SectionIndex = Root.FindSection( SectionName );
+	if (SectionIndex == INDEX_NONE)
+	{
+		return false;
+	}
+	NumSet = Binder.Import( Root, SectionIndex, Data );
+	return true;
+}
+
+TSharedPtr<IniRoot> IniRoot::FromBuffer( TArray<TCHAR>&& Text, int32 InFileOrigin )
+{
+	TSharedPtr<IniRoot> RootIni( new IniRoot( ) );
+	RootIni->Chars = MoveTemp( Text );
+	if (RootIni->Chars.Num( ) > 0 && RootIni->Chars.Last( ) == TEXT( '\0' ))
+	{
+		RootIni->Chars.Pop( false );
+	}
+
+	// Sections[0] collects the lines in front of the first header
+	IniSection VirtualSection;
+	VirtualSection.IsVirtual = true;
+	RootIni->Sections.Add( VirtualSection );
+
+	TArray<IniScannedLine> Lines;
+	IniScanner::ScanLines( RootIni->Chars.GetData( ), RootIni->Chars.Num( ), Lines );
+	RootIni->Entries.Reserve( Lines.Num( ) );
+	INC_DWORD_STAT_BY( STAT_IniLinesParsed, Lines.Num( ) );
+
+	int32 SectionIndex = 0;
+	for (int i = 0; i < Lines.Num( ); ++i)
+	{
+		RootIni->ParseLine( RootIni->Chars.GetData( ), SectionIndex, Lines[i], InFileOrigin );
+	}
+	return MoveTemp( RootIni );
+}
+
+TSharedPtr<IniRoot> IniRoot::FromBufferLazy( TArray<TCHAR>&& Text, int32 InFileOrigin )
+{
+	TSharedPtr<IniRoot> RootIni( new IniRoot( ) );
+	RootIni->Chars = MoveTemp( Text );
+	if (RootIni->Chars.Num( ) > 0 && RootIni->Chars.Last( ) == TEXT( '\0' ))
+	{
+		RootIni->Chars.Pop( false );
+	}
+	RootIni->FileOrigin = InFileOrigin;
+
+	IniSection VirtualSection;
+	VirtualSection.IsVirtual = true;
+	RootIni->Sections.Add( VirtualSection );
+
+	TArray<IniScannedLine> Headers;
+	IniScanner::ScanSections( RootIni->Chars.GetData( ), RootIni->Chars.Num( ), Headers );
+	RootIni->AddPendingSections( RootIni->Chars.GetData( ), RootIni->Chars.Num( ), Headers );
+	return MoveTemp( RootIni );
+}
+
+TSharedPtr<IniRoot> IniRoot::FromBytes( const IniByteSourcePtr& InSource, int32 InFileOrigin )
+{
+	TSharedPtr<IniRoot> RootIni( new IniRoot( ) );
+	RootIni->Source = InSource;
+	RootIni->FileOrigin = InFileOrigin;
+	RootIni->SourceBytes = InSource->Size;
+
+	IniSection VirtualSection;
+	VirtualSection.IsVirtual = true;
+	RootIni->Sections.Add( VirtualSection );
+
+	const ANSICHAR* Text = (const ANSICHAR*)InSource->Data + InFileOrigin;
+	const int32 TextLen = InSource->Size - InFileOrigin;
+	// Sections are converted into Chars as they are read, while views handed out earlier
+	// still point into it, so Chars must never move. UTF-8 never converts to more TCHARs
+	// than it has bytes and each byte is converted at most once, so the whole text fits;
+	// pages of the reservation no section is read into are not touched.
+	RootIni->Chars.Reserve( TextLen );
+	TArray<IniScannedLine> Headers;
+	IniScanner::ScanSections( Text, TextLen, Headers );
+	RootIni->AddPendingSections( Text, TextLen, Headers );
+	return MoveTemp( RootIni );
+}
+
+TSharedPtr<IniRoot> IniRoot::FromUtf8( TArray<uint8>&& Bytes, int32 InFileOrigin )
+{
+	TSharedPtr<IniRoot> RootIni( new IniRoot( ) );
+	RootIni->bUtf8 = true;
+	RootIni->Utf8Chars = MoveTemp( Bytes );
+	// the byte order mark is not text; FileOrigin keeps the file offsets right
+	RootIni->Utf8Chars.RemoveAt( 0, InFileOrigin, false );
+
+	IniSection VirtualSection;
+	VirtualSection.IsVirtual = true;
+	RootIni->Sections.Add( VirtualSection );
+
+	const ANSICHAR* Text = (const ANSICHAR*)RootIni->Utf8Chars.GetData( );
+	TArray<IniScannedLine> Lines;
+	IniScanner::ScanLines( Text, RootIni->Utf8Chars.Num( ), Lines );
+	RootIni->Entries.Reserve( Lines.Num( ) );
+	INC_DWORD_STAT_BY( STAT_IniLinesParsed, Lines.Num( ) );
+
+	int32 SectionIndex = 0;
+	for (int i = 0; i < Lines.Num( ); ++i)
+	{
+		RootIni->ParseLine( Text, SectionIndex, Lines[i], InFileOrigin );
+	}
+	return MoveTemp( RootIni );
+}
+
+template <typename CharType>
+void IniRoot::AddPendingSections( const CharType* Text, int32 TextLen, const TArray<IniScannedLine>& Headers )
+{
+	Sections.Reserve( Headers.Num( ) + 1 );
+	INC_DWORD_STAT_BY( STAT_IniLinesParsed, Headers.Num( ) );
+	Sections[0].bParsed = false;
+	Sections[0].BodyStart = 0;
+	Sections[0].BodyLen = (Headers.Num( ) > 0) ? Headers[0].Start : TextLen;
+	++NumPendingSections;
+
+	TArray<IniScannedLine> HeaderLine;
+	for (int i = 0; i < Headers.Num( ); ++i)
+	{
+		const IniScannedLine& Header = Headers[i];
+		int32 SectionIndex = INDEX_NONE;
+		if (Source)
+		{
+			// header text goes into Chars, converted
+			const FUTF8ToTCHAR Converted( Text + Header.Start, Header.Len );
+			const int32 Base = Chars.Num( );
+			checkSlow( Base + Converted.Length( ) <= Chars.Max( ) );
+			Chars.Append( Converted.Get( ), Converted.Length( ) );
+			IniScanner::ScanLines( Chars.GetData( ) + Base, Converted.Length( ), HeaderLine );
+			HeaderLine[0].Start += Base;
+			ParseLine( Chars.GetData( ), SectionIndex, HeaderLine[0], FileOrigin + Header.Start - Base );
+		}
+		else
+		{
+			ParseLine( Chars.GetData( ), SectionIndex, Header, FileOrigin );
+		}
+
+		// the body starts behind the header's line terminator
+		int32 BodyStart = Header.Start + Header.Len;
+		if (BodyStart < TextLen && Text[BodyStart] == '\r')
+		{
+			++BodyStart;
+		}
+		BodyStart = FMath::Min( BodyStart + 1, TextLen );
+		const int32 BodyEnd = (i + 1 < Headers.Num( )) ? Headers[i + 1].Start : TextLen;
+
+		IniSection& Section = Sections[SectionIndex];
+		Section.bParsed = false;
+		Section.BodyStart = BodyStart;
+		Section.BodyLen = BodyEnd - BodyStart;
+		++NumPendingSections;
+	}
+
+	BuildIndex( );
+	// lines in front of the first header are few and FindSection needs their count
+	ParseSection( 0 );
+}
+
+void IniRoot::ParseSection( int32 SectionIndex )
+{
+	if (Sections[SectionIndex].bParsed)
+	{
+		return;
+	}
+	SCOPE_CYCLE_COUNTER( STAT_IniParseSection );
+	Sections[SectionIndex].bParsed = true;
+	--NumPendingSections;
+
+	int32 Base = Sections[SectionIndex].BodyStart;
+	int32 Len = Sections[SectionIndex].BodyLen;
+	int32 Origin = FileOrigin;
+	if (Source)
+	{
+		// mapped text stays UTF-8, only the sections that are read get converted
+		const FUTF8ToTCHAR Converted( (const ANSICHAR*)Source->Data + FileOrigin + Base, Len );
+		Origin = FileOrigin + Base - Chars.Num( );
+		Base = Chars.Num( );
+		Len = Converted.Length( );
+		// reserved by FromBytes, appending does not move the text views point into
+		checkSlow( Base + Len <= Chars.Max( ) );
+		Chars.Append( Converted.Get( ), Len );
+	}
+
+	TArray<IniScannedLine> Lines;
+	IniScanner::ScanLines( Chars.GetData( ) + Base, Len, Lines );
+	Entries.Reserve( Entries.Num( ) + Lines.Num( ) );
+	INC_DWORD_STAT_BY( STAT_IniLinesParsed, Lines.Num( ) );
+	for (int i = 0; i < Lines.Num( ); ++i)
+	{
+		int32 EntrySection = SectionIndex;
+		Lines[i].Start += Base;
+		ParseLine( Chars.GetData( ), EntrySection, Lines[i], Origin );
+	}
+}
+
+void IniRoot::Diff( const IniRoot& OldRoot, const IniRoot& NewRoot, TArray<IniValueChange>& OutChanges )
+{
+	FString NewScratch;
+	FString OldScratch;
+	ForEachVisibleValue( NewRoot, [&]( int32 SectionIndex, int32 EntryIndex )
+	{
+		const FStringView NewValue = NewRoot.GetString( NewRoot.Entries[EntryIndex].Value, NewScratch );
+		const int32 OldEntry = FindMatchingValue( NewRoot, SectionIndex, EntryIndex, OldRoot );
+		const FStringView OldValue = (OldEntry != INDEX_NONE) ? OldRoot.GetString( OldRoot.Entries[OldEntry].Value, OldScratch ) : FStringView( );
+		if (OldEntry == INDEX_NONE || !IsSameValue( OldValue, NewValue ))
+		{
+			IniValueChange& Change = OutChanges.AddDefaulted_GetRef( );
+			Change.SectionName = NewRoot.ToString( NewRoot.Sections[SectionIndex].Name );
+			Change.Name = NewRoot.ToString( NewRoot.Entries[EntryIndex].Name );
+			Change.OldValue = FString( OldValue );
+			Change.NewValue = FString( NewValue );
+			Change.bAdded = (OldEntry == INDEX_NONE);
+		}
+	} );
+
+	ForEachVisibleValue( OldRoot, [&]( int32 SectionIndex, int32 EntryIndex )
+	{
+		if (FindMatchingValue( OldRoot, SectionIndex, EntryIndex, NewRoot ) == INDEX_NONE)
+		{
+			IniValueChange& Change = OutChanges.AddDefaulted_GetRef( );
+			Change.SectionName = OldRoot.ToString( OldRoot.Sections[SectionIndex].Name );
+			Change.Name = OldRoot.ToString( OldRoot.Entries[EntryIndex].Name );
+			Change.OldValue = OldRoot.ToString( OldRoot.Entries[EntryIndex].Value );
+			Change.bRemoved = true;
+		}
+	} );
+}
+
+void IniRoot::ParseAllSections( )
+{
+	for (int i = 0; i < Sections.Num( ) && HasPendingSections( ); ++i)
+	{
+		ParseSection( i );
+	}
+}
+
+void IniRoot::ParseAllSectionsParallel( )
+{
+	// below this much text per run the tasks cost more than they save
+	const int32 MinRunChars = 256 * 1024;
+
+	int64 PendingChars = 0;
+	for (const IniSection& Section : Sections)
+	{
+		PendingChars += Section.bParsed ? 0 : Section.BodyLen;
+	}
+	const int32 MaxRuns = FMath::Max( 1, FTaskGraphInterface::Get( ).GetNumWorkerThreads( ) * 2 );
+	const int32 NumRuns = (int32)FMath::Clamp<int64>( PendingChars / MinRunChars, 1, MaxRuns );
+	if (Source || NumRuns == 1)
+	{
+		ParseAllSections( );
+		return;
+	}
+
+	// runs of whole sections, each ending once it holds its share of the text
+	struct FRun
+	{
+		int32 FirstSection;
+		int32 EndSection;
+		TArray<IniSectionContentEntry> Entries;
+		int32 FirstEntry;
+	};
+	TArray<FRun> Runs;
+	const int64 CharsPerRun = PendingChars / NumRuns + 1;
+	int64 RunChars = 0;
+	for (int i = 0; i < Sections.Num( ); ++i)
+	{
+		if (Runs.Num( ) == 0 || RunChars >= CharsPerRun)
+		{
+			FRun& Run = Runs.AddDefaulted_GetRef( );
+			Run.FirstSection = i;
+			RunChars = 0;
+		}
+		Runs.Last( ).EndSection = i + 1;
+		RunChars += Sections[i].bParsed ? 0 : Sections[i].BodyLen;
+	}
+
+	// the text is only read here: every run scans its own sections into its own array
+	ParallelFor( Runs.Num( ), [&]( int32 RunIndex )
+	{
+		FRun& Run = Runs[RunIndex];
+		TArray<IniScannedLine> Lines;
+		for (int32 SectionIndex = Run.FirstSection; SectionIndex < Run.EndSection; ++SectionIndex)
+		{
+			const IniSection& Section = Sections[SectionIndex];
+			if (Section.bParsed)
+			{
+				continue;
+			}
+			IniScanner::ScanLines( Chars.GetData( ) + Section.BodyStart, Section.BodyLen, Lines );
+			for (IniScannedLine& Line : Lines)
+			{
+				// bodies end in front of the next header
+				checkSlow( Line.Kind != EIniLineKind::Section );
+				Line.Start += Section.BodyStart;
+				IniSectionContentEntry& Entry = Run.Entries.AddDefaulted_GetRef( );
+				InitEntry( Chars.GetData( ), Line, FileOrigin, Entry );
+				Entry.Section = SectionIndex;
+			}
+		}
+	} );
+
+	int32 NumEntries = Entries.Num( );
+	for (FRun& Run : Runs)
+	{
+		Run.FirstEntry = NumEntries;
+		NumEntries += Run.Entries.Num( );
+	}
+	INC_DWORD_STAT_BY( STAT_IniLinesParsed, NumEntries - Entries.Num( ) );
+	Entries.AddUninitialized( NumEntries - Entries.Num( ) );
+
+	// runs own disjoint sections and entry ranges, so they are joined in parallel too
+	ParallelFor( Runs.Num( ), [&]( int32 RunIndex )
+	{
+		FRun& Run = Runs[RunIndex];
+		FMemory::Memcpy( Entries.GetData( ) + Run.FirstEntry, Run.Entries.GetData( ), Run.Entries.Num( ) * sizeof( IniSectionContentEntry ) );
+		for (int32 EntryIndex = Run.FirstEntry; EntryIndex < Run.FirstEntry + Run.Entries.Num( ); ++EntryIndex)
+		{
+			IniSectionContentEntry& Entry = Entries[EntryIndex];
+			IniSection& Section = Sections[Entry.Section];
+			if (Section.LastEntry != INDEX_NONE)
+			{
+				Entries[Section.LastEntry].Next = EntryIndex;
+			}
+			else
+			{
+				Section.FirstEntry = EntryIndex;
+			}
+			Section.LastEntry = EntryIndex;
+			++Section.NumEntries;
+		}
+		for (int32 SectionIndex = Run.FirstSection; SectionIndex < Run.EndSection; ++SectionIndex)
+		{
+			Sections[SectionIndex].bParsed = true;
+		}
+	} );
+	NumPendingSections = 0;
+
+	BuildIndex( );
+}
+
+template <typename CharType>
+void IniRoot::ParseLine( const CharType* Base, int32& SectionIndex, const IniScannedLine& Line, int32 InFileOrigin )
+{
+	if (Line.Kind != EIniLineKind::Section)
+	{
+		IniSectionContentEntry Entry;
+		InitEntry( Base, Line, InFileOrigin, Entry );
+		AppendEntry( SectionIndex, Entry );
+		return;
+	}
+
+	// "[name]", the closing bracket is assumed to be the last character
+	const IniStringRef Raw( Line.Start, Line.Len );
+	const CharType* Text = Base + Raw.Offset;
+	int32 NameStart = Line.TrimStart + 1;
+	int32 NameEnd = FMath::Max( NameStart, Line.TrimEnd - 1 );
+	IniScanner::TrimRange( Text, NameStart, NameEnd );
+
+	IniSection Section;
+	Section.Raw = Raw;
+	Section.Name = Raw.Slice( NameStart, NameEnd - NameStart );
+	Section.NameHash = HashName( Text + NameStart, NameEnd - NameStart );
+	Section.NameId = InternName( Text + NameStart, NameEnd - NameStart, Section.NameHash );
+	Section.File = IniFileLine( InFileOrigin + Line.Start, Line.Len );
+	SectionIndex = Sections.Add( Section );
+	IndexSection( SectionIndex );
+}
+
+template <typename CharType>
+void IniRoot::InitEntry( const CharType* Base, const IniScannedLine& Line, int32 InFileOrigin, IniSectionContentEntry& Entry ) const
+{
+	// the scanner already trimmed the line and located its first '='
+	const IniStringRef Raw( Line.Start, Line.Len );
+	const CharType* Text = Base + Raw.Offset;
+	Entry.Raw = Raw;
+	Entry.File = IniFileLine( InFileOrigin + Line.Start, Line.Len );
+
+	switch (Line.Kind)
+	{
+	case EIniLineKind::Comment:
+		{
+			// comment starts with # or //
+			int32 TextStart = Line.TrimStart + (Text[Line.TrimStart] == '#' ? 1 : 2);
+			int32 TextEnd = Line.TrimEnd;
+			IniScanner::TrimRange( Text, TextStart, TextEnd );
+			Entry.SubType = eComment;
+			Entry.Name = Raw.Slice( TextStart, TextEnd - TextStart );
+		}
+		break;
+	case EIniLineKind::NameValue:
+		{
+			int32 NameStart = Line.TrimStart;
+			int32 NameEnd = Line.Equal;
+			IniScanner::TrimRange( Text, NameStart, NameEnd );
+			int32 ValueStart = Line.Equal + 1;
+			int32 ValueEnd = Line.TrimEnd;
+			IniScanner::TrimRange( Text, ValueStart, ValueEnd );
+			Entry.SubType = eNameValuePair;
+			Entry.Name = Raw.Slice( NameStart, NameEnd - NameStart );
+			Entry.Value = Raw.Slice( ValueStart, ValueEnd - ValueStart );
+			Entry.NameHash = HashName( Text + NameStart, NameEnd - NameStart );
+			Entry.NameId = InternName( Text + NameStart, NameEnd - NameStart, Entry.NameHash );
+		}
+		break;
+	case EIniLineKind::OnlyName:
+		Entry.SubType = eOnlyName;
+		Entry.Name = Raw.Slice( Line.TrimStart, Line.TrimEnd - Line.TrimStart );
+		Entry.NameHash = HashName( Text + Line.TrimStart, Line.TrimEnd - Line.TrimStart );
+		Entry.NameId = InternName( Text + Line.TrimStart, Line.TrimEnd - Line.TrimStart, Entry.NameHash );
+		break;
+	default:
+		Entry.SubType = eWhiteLine;
+		break;
+	}
+}
+
+void IniRoot::BuildIndex( )
+{
+	SCOPE_CYCLE_COUNTER( STAT_IniBuildIndex );
+	SectionIndexLevel.Init( INDEX_NONE, GetBucketCount( Sections.Num( ) ) );
+	NameIndexLevel.Init( INDEX_NONE, GetBucketCount( Entries.Num( ) ) );
+	INC_DWORD_STAT_BY( STAT_IniIndexBuckets, SectionIndexLevel.Num( ) + NameIndexLevel.Num( ) );
+
+	// later sections and entries shadow earlier ones with the same name
+	for (int i = 0; i < Sections.Num( ); ++i)
+	{
+		IndexSection( i );
+	}
+	for (int i = 0; i < Entries.Num( ); ++i)
+	{
+		IndexEntry( i );
+	}
+}
+
+void IniRoot::SetBatchOpen( bool bOpen )
+{
+	bBatchOpen = bOpen;
+	if (!bOpen && SectionIndexLevel.Num( ) > 0
+		&& (Sections.Num( ) > SectionIndexLevel.Num( ) * 2 || Entries.Num( ) > NameIndexLevel.Num( ) * 2))
+	{
+		BuildIndex( );
+	}
+}
+
+void IniRoot::IndexSection( int32 SectionIndex )
+{
+	if (SectionIndexLevel.Num( ) == 0)
+	{
+		// BuildIndex has not run yet
+		return;
+	}
+	if (!bBatchOpen && Sections.Num( ) > SectionIndexLevel.Num( ) * 2)
+	{
+		BuildIndex( );
+		return;
+	}
+
+	IniSection& Section = Sections[SectionIndex];
+	if (!Section.IsVirtual)
+	{
+		int32& Bucket = SectionIndexLevel[Section.NameHash & (SectionIndexLevel.Num( ) - 1)];
+		Section.HashNext = Bucket;
+		Bucket = SectionIndex;
+	}
+}
+
+void IniRoot::IndexEntry( int32 EntryIndex )
+{
+	if (NameIndexLevel.Num( ) == 0)
+	{
+		return;
+	}
+	if (!bBatchOpen && Entries.Num( ) > NameIndexLevel.Num( ) * 2)
+	{
+		BuildIndex( );
+		return;
+	}
+
+	IniSectionContentEntry& Entry = Entries[EntryIndex];
+	if (Entry.SubType == eNameValuePair || Entry.SubType == eOnlyName)
+	{
+		int32& Bucket = NameIndexLevel[HashCombine( Entry.NameHash, (uint32)Entry.Section ) & (NameIndexLevel.Num( ) - 1)];
+		Entry.HashNext = Bucket;
+		Bucket = EntryIndex;
+	}
+}
+
+int32 IniRoot::FindSection( FStringView SectionName ) const
+{
+	if (IsVirtualSectionName( SectionName ))
+	{
+		return (Sections.Num( ) > 0 && Sections[0].NumEntries > 0) ? 0 : INDEX_NONE;
+	}
+	if (bUtf8)
+	{
+		const FTCHARToUTF8 Key( SectionName.GetData( ), SectionName.Len( ) );
+		return FindSectionUtf8( Key.Get( ), Key.Length( ) );
+	}
+	return FindSection( SectionName, HashName( SectionName.GetData( ), SectionName.Len( ) ) );
+}
+
+int32 IniRoot::FindSection( FStringView SectionName, uint32 Hash ) const
+{
+	if (bUtf8)
+	{
+		// Hash is the one of the TCHAR name
+		const FTCHARToUTF8 Key( SectionName.GetData( ), SectionName.Len( ) );
+		return FindSectionUtf8( Key.Get( ), Key.Length( ) );
+	}
+	return FindSectionById( Hash, FIniNameTable::Get( ).Find( SectionName, Hash ) );
+}
+
+int32 IniRoot::FindSectionById( uint32 Hash, uint32 NameId ) const
+{
+	// no document has a name that was never interned
+	if (NameId == FIniNameTable::NoName || SectionIndexLevel.Num( ) == 0)
+	{
+		return INDEX_NONE;
+	}
+
+	for (int32 i = SectionIndexLevel[Hash & (SectionIndexLevel.Num( ) - 1)]; i != INDEX_NONE; i = Sections[i].HashNext)
+	{
+		if (Sections[i].NameId == NameId)
+		{
+			return i;
+		}
+	}
+	return INDEX_NONE;
+}
+
+int32 IniRoot::FindEntry( int32 SectionIndex, FStringView Name ) const
+{
+	if (bUtf8)
+	{
+		const FTCHARToUTF8 Key( Name.GetData( ), Name.Len( ) );
+		return FindEntryUtf8( SectionIndex, Key.Get( ), Key.Length( ) );
+	}
+	return FindEntry( SectionIndex, Name, HashName( Name.GetData( ), Name.Len( ) ) );
+}
+
+int32 IniRoot::FindEntry( int32 SectionIndex, FStringView Name, uint32 Hash ) const
+{
+	if (bUtf8)
+	{
+		const FTCHARToUTF8 Key( Name.GetData( ), Name.Len( ) );
+		return FindEntryUtf8( SectionIndex, Key.Get( ), Key.Length( ) );
+	}
+	return FindEntryById( SectionIndex, Hash, FIniNameTable::Get( ).Find( Name, Hash ) );
+}
+
+int32 IniRoot::FindEntryById( int32 SectionIndex, uint32 Hash, uint32 NameId ) const
+{
+	// no document has a name that was never interned
+	if (NameId == FIniNameTable::NoName || NameIndexLevel.Num( ) == 0)
+	{
+		return INDEX_NONE;
+	}
+
+	for (int32 i = NameIndexLevel[HashCombine( Hash, (uint32)SectionIndex ) & (NameIndexLevel.Num( ) - 1)]; i != INDEX_NONE; i = Entries[i].HashNext)
+	{
+		const IniSectionContentEntry& Entry = Entries[i];
+		if (Entry.Section == SectionIndex && Entry.NameId == NameId)
+		{
+			return i;
+		}
+	}
+	return INDEX_NONE;
+}
+
+int32 IniRoot::FindSectionUtf8( const ANSICHAR* SectionName, int32 Len ) const
+{
+	if (SectionIndexLevel.Num( ) == 0)
+	{
+		return INDEX_NONE;
+	}
+
+	const uint32 Hash = HashName( SectionName, Len );
+	for (int32 i = SectionIndexLevel[Hash & (SectionIndexLevel.Num( ) - 1)]; i != INDEX_NONE; i = Sections[i].HashNext)
+	{
+		const IniSection& Section = Sections[i];
+		if (Section.NameHash == Hash && Section.Name.Len == Len && FCStringAnsi::Strnicmp( GetUtf8Chars( Section.Name ), SectionName, Len ) == 0)
+		{
+			return i;
+		}
+	}
+	return INDEX_NONE;
+}
+
+int32 IniRoot::FindEntryUtf8( int32 SectionIndex, const ANSICHAR* Name, int32 Len ) const
+{
+	if (NameIndexLevel.Num( ) == 0)
+	{
+		return INDEX_NONE;
+	}
+
+	const uint32 Hash = HashName( Name, Len );
+	for (int32 i = NameIndexLevel[HashCombine( Hash, (uint32)SectionIndex ) & (NameIndexLevel.Num( ) - 1)]; i != INDEX_NONE; i = Entries[i].HashNext)
+	{
+		const IniSectionContentEntry& Entry = Entries[i];
+		if (Entry.Section == SectionIndex && Entry.NameHash == Hash && Entry.Name.Len == Len && FCStringAnsi::Strnicmp( GetUtf8Chars( Entry.Name ), Name, Len ) == 0)
+		{
+			return i;
+		}
+	}
+	return INDEX_NONE;
+}
+
+int32 IniRoot::LookupEntry( FStringView SectionName, FStringView Name ) const
+{
+	const int32 SectionIndex = FindSection( SectionName );
+	return (SectionIndex != INDEX_NONE) ? FindEntry( SectionIndex, Name ) : INDEX_NONE;
+}
+
+bool IniRoot::GetValue( FStringView SectionName, FStringView Name, FStringView& Val, bool& IsValid ) const
+{
+	const int32 EntryIndex = LookupEntry( SectionName, Name );
+	if (EntryIndex == INDEX_NONE)
+	{
+		return false;
+	}
+	const IniSectionContentEntry& Entry = Entries[EntryIndex];
+	if (Entry.SubType == eNameValuePair)
+	{
+		IsValid = true;
+		Val = GetView( Entry.Value );
+	}
+	return true;
+}
+
+bool IniRoot::GetValue( FStringView SectionName, FStringView Name, FString& Val, bool& IsValid ) const
+{
+	const int32 EntryIndex = LookupEntry( SectionName, Name );
+	if (EntryIndex == INDEX_NONE)
+	{
+		return false;
+	}
+	const IniSectionContentEntry& Entry = Entries[EntryIndex];
+	if (Entry.SubType == eNameValuePair)
+	{
+		IsValid = true;
+		Val = ToString( Entry.Value );
+	}
+	return true;
+}
+
+bool IniRoot::GetSectionValues( FStringView SectionName, TArray<TPair<FStringView, FStringView>>& OutValues ) const
+{
+	OutValues.Reset( );
+	const int32 SectionIndex = FindSection( SectionName );
+	if (SectionIndex == INDEX_NONE)
+	{
+		return false;
+	}
+
+	const IniSection& Section = Sections[SectionIndex];
+	OutValues.Reserve( Section.NumEntries );
+	for (int32 EntryIndex = Section.FirstEntry; EntryIndex != INDEX_NONE; EntryIndex = Entries[EntryIndex].Next)
+	{
+		const IniSectionContentEntry& Entry = Entries[EntryIndex];
+		if (Entry.SubType == eNameValuePair)
+		{
+			OutValues.Emplace( GetView( Entry.Name ), GetView( Entry.Value ) );
+		}
+	}
+	return true;
+}
+
+bool IniRoot::GetValues( FStringView SectionName, const TArray<FString>& Names, TArray<FStringView>& OutValues, TArray<bool>& OutValid ) const
+{
+	OutValues.Init( FStringView( ), Names.Num( ) );
+	OutValid.Init( false, Names.Num( ) );
+	const int32 SectionIndex = FindSection( SectionName );
+	if (SectionIndex == INDEX_NONE)
+	{
+		return false;
+	}
+
+	for (int i = 0; i < Names.Num( ); ++i)
+	{
+		const int32 EntryIndex = FindEntry( SectionIndex, Names[i] );
+		if (EntryIndex != INDEX_NONE && Entries[EntryIndex].SubType == eNameValuePair)
+		{
+			OutValues[i] = GetView( Entries[EntryIndex].Value );
+			OutValid[i] = true;
+		}
+	}
+	return true;
+}
+
+int32 IniRoot::AddSection( FStringView SectionName )
+{
+	if (IsVirtualSectionName( SectionName ))
+	{
+		return 0;
+	}
+
+	IniSection Section;
+	if (bUtf8)
+	{
+		const FTCHARToUTF8 Name( SectionName.GetData( ), SectionName.Len( ) );
+		Section.Raw = IniStringRef( Utf8Chars.Num( ), Name.Length( ) + 2 );
+		Section.Name = Section.Raw.Slice( 1, Name.Length( ) );
+		Section.NameHash = HashName( Name.Get( ), Name.Length( ) );
+		Utf8Chars.Add( '[' );
+		Utf8Chars.Append( (const uint8*)Name.Get( ), Name.Length( ) );
+		Utf8Chars.Add( ']' );
+	}
+	else
+	{
+		Section.Raw = IniStringRef( Chars.Num( ), SectionName.Len( ) + 2 );
+		Section.Name = Section.Raw.Slice( 1, SectionName.Len( ) );
+		Section.NameHash = HashName( SectionName.GetData( ), SectionName.Len( ) );
+		Section.NameId = InternName( SectionName.GetData( ), SectionName.Len( ), Section.NameHash );
+		Chars.Add( TEXT( '[' ) );
+		Chars.Append( SectionName.GetData( ), SectionName.Len( ) );
+		Chars.Add( TEXT( ']' ) );
+	}
+
+	const int32 SectionIndex = Sections.Add( Section );
+	IndexSection( SectionIndex );
+	return SectionIndex;
+}
+
+int32 IniRoot::AddEntry( int32 SectionIndex, LineType SubType, IniStringRef Raw, IniStringRef Name, IniStringRef Value )
+{
+	IniSectionContentEntry Entry;
+	Entry.SubType = SubType;
+	Entry.Raw = Raw;
+	Entry.Name = Name;
+	Entry.Value = Value;
+	if (SubType == eNameValuePair || SubType == eOnlyName)
+	{
+		if (bUtf8)
+		{
+			Entry.NameHash = HashName( GetUtf8Chars( Name ), Name.Len );
+		}
+		else
+		{
+			Entry.NameHash = HashName( GetChars( Name ), Name.Len );
+			Entry.NameId = InternName( GetChars( Name ), Name.Len, Entry.NameHash );
+		}
+	}
+	return AppendEntry( SectionIndex, Entry );
+}
+
+int32 IniRoot::AppendEntry( int32 SectionIndex, const IniSectionContentEntry& NewEntry )
+{
+	const int32 EntryIndex = Entries.Add( NewEntry );
+	IniSectionContentEntry& Entry = Entries[EntryIndex];
+	Entry.Section = SectionIndex;
+
+	IniSection& Section = Sections[SectionIndex];
+	if (Section.LastEntry != INDEX_NONE)
+	{
+		Entries[Section.LastEntry].Next = EntryIndex;
+	}
+	else
+	{
+		Section.FirstEntry = EntryIndex;
+	}
+	Section.LastEntry = EntryIndex;
+	++Section.NumEntries;
+
+	IndexEntry( EntryIndex );
+	return EntryIndex;
+}
+
+void IniRoot::SetEntryValue( int32 EntryIndex, FStringView Name, FStringView Val )
+{
+	IniSectionContentEntry& Entry = Entries[EntryIndex];
+	const bool bWasIndexed = (Entry.SubType == eNameValuePair || Entry.SubType == eOnlyName);
+
+	// the new line goes over the old one when it fits, otherwise behind the text;
+	// within a batch the old text has to stay for the undo
+	Entry.SubType = eNameValuePair;
+	if (bUtf8)
+	{
+		Views.Reset( );
+		const FTCHARToUTF8 Utf8Name( Name.GetData( ), Name.Len( ) );
+		const FTCHARToUTF8 Utf8Val( Val.GetData( ), Val.Len( ) );
+		const int32 Len = Utf8Name.Length( ) + 1 + Utf8Val.Length( );
+		const bool bInPlace = !bBatchOpen && Len <= Entry.Raw.Len;
+		const int32 Offset = bInPlace ? Entry.Raw.Offset : Utf8Chars.Num( );
+		NumDeadChars += Entry.Raw.Len - (bInPlace ? Len : 0);
+		if (!bInPlace)
+		{
+			Utf8Chars.AddUninitialized( Len );
+		}
+		uint8* Dest = Utf8Chars.GetData( ) + Offset;
+		FMemory::Memcpy( Dest, Utf8Name.Get( ), Utf8Name.Length( ) );
+		Dest[Utf8Name.Length( )] = '=';
+		FMemory::Memcpy( Dest + Utf8Name.Length( ) + 1, Utf8Val.Get( ), Utf8Val.Length( ) );
+
+		Entry.Raw = IniStringRef( Offset, Len );
+		Entry.Name = Entry.Raw.Slice( 0, Utf8Name.Length( ) );
+		Entry.Value = Entry.Raw.Slice( Utf8Name.Length( ) + 1, Utf8Val.Length( ) );
+		Entry.NameHash = HashName( Utf8Name.Get( ), Utf8Name.Length( ) );
+	}
+	else
+	{
+		const int32 Len = Name.Len( ) + 1 + Val.Len( );
+		const bool bInPlace = !bBatchOpen && Len <= Entry.Raw.Len;
+		const int32 Offset = bInPlace ? Entry.Raw.Offset : Chars.Num( );
+		NumDeadChars += Entry.Raw.Len - (bInPlace ? Len : 0);
+		if (!bInPlace)
+		{
+			Chars.AddUninitialized( Len );
+		}
+		TCHAR* Dest = Chars.GetData( ) + Offset;
+		FMemory::Memcpy( Dest, Name.GetData( ), Name.Len( ) * sizeof( TCHAR ) );
+		Dest[Name.Len( )] = TEXT( '=' );
+		FMemory::Memcpy( Dest + Name.Len( ) + 1, Val.GetData( ), Val.Len( ) * sizeof( TCHAR ) );
+
+		Entry.Raw = IniStringRef( Offset, Len );
+		Entry.Name = Entry.Raw.Slice( 0, Name.Len( ) );
+		Entry.Value = Entry.Raw.Slice( Name.Len( ) + 1, Val.Len( ) );
+		Entry.NameHash = HashName( Name.GetData( ), Name.Len( ) );
+		Entry.NameId = InternName( Name.GetData( ), Name.Len( ), Entry.NameHash );
+	}
+	Entry.File.bDirty = true;
+
+	if (!bWasIndexed)
+	{
+		IndexEntry( EntryIndex );
+	}
+
+	// values that keep growing would otherwise leave most of the text unused
+	if (!bBatchOpen && !HasPendingSections( ) && NumDeadChars > FMath::Max( GetTextLen( ) / 2, 4096 ))
+	{
+		CompactText( );
+	}
+}
+
+void IniRoot::CompactText( )
+{
+	check( !HasPendingSections( ) && !bBatchOpen );
+
+	const int32 NumLiveChars = GetTextLen( ) - NumDeadChars;
+	if (bUtf8)
+	{
+		Views.Reset( );
+		TArray<uint8> NewText;
+		NewText.Reserve( NumLiveChars );
+		for (IniSection& Section : Sections)
+		{
+			IniStringRef NoValue;
+			MoveLine( NewText, Utf8Chars, Section.Raw, Section.Name, NoValue );
+		}
+		for (IniSectionContentEntry& Entry : Entries)
+		{
+			MoveLine( NewText, Utf8Chars, Entry.Raw, Entry.Name, Entry.Value );
+		}
+		Utf8Chars = MoveTemp( NewText );
+	}
+	else
+	{
+		TArray<TCHAR> NewText;
+		NewText.Reserve( NumLiveChars );
+		for (IniSection& Section : Sections)
+		{
+			IniStringRef NoValue;
+			MoveLine( NewText, Chars, Section.Raw, Section.Name, NoValue );
+		}
+		for (IniSectionContentEntry& Entry : Entries)
+		{
+			MoveLine( NewText, Chars, Entry.Raw, Entry.Name, Entry.Value );
+		}
+		Chars = MoveTemp( NewText );
+	}
+	NumDeadChars = 0;
+}
+
+IniStringRef IniRoot::AddString( const TCHAR* Str, int32 Len )
+{
+	if (bUtf8)
+	{
+		const FTCHARToUTF8 Converted( Str, Len );
+		const IniStringRef Ref( Utf8Chars.Num( ), Converted.Length( ) );
+		Utf8Chars.Append( (const uint8*)Converted.Get( ), Converted.Length( ) );
+		return Ref;
+	}
+	const IniStringRef Ref( Chars.Num( ), Len );
+	Chars.Append( Str, Len );
+	return Ref;
+}
+
+FStringView IniRoot::GetString( IniStringRef Ref, FString& Scratch ) const
+{
+	if (!bUtf8)
+	{
+		return GetString( Ref );
+	}
+	Scratch = ToString( Ref );
+	return Scratch;
+}
+
+FStringView IniRoot::GetView( IniStringRef Ref ) const
+{
+	if (!bUtf8)
+	{
+		return GetString( Ref );
+	}
+
+	const uint64 Key = ((uint64)Ref.Offset << 32) | (uint32)Ref.Len;
+	FScopeLock ScopeLock( &Views.Lock );
+	FString* Found = Views.Strings.Find( Key );
+	if (!Found)
+	{
+		// the map moves its FStrings when it grows, their characters stay where they are
+		Found = &Views.Strings.Add( Key, ToString( Ref ) );
+	}
+	return *Found;
+}
+
+FString IniRoot::ToString( IniStringRef Ref ) const
+{
+	if (bUtf8)
+	{
+		const FUTF8ToTCHAR Converted( GetUtf8Chars( Ref ), Ref.Len );
+		return FString( Converted.Length( ), Converted.Get( ) );
+	}
+	return FString( Ref.Len, GetChars( Ref ) );
+}
+
+bool IniRoot::HasLines( ) const
+{
+	return Sections.Num( ) > 1 || (Sections.Num( ) == 1 && Sections[0].NumEntries > 0);
+}
+
+SIZE_T IniRoot::GetAllocatedSize( ) const
+{
+	return sizeof( IniRoot )
+		+ Chars.GetAllocatedSize( )
+		+ Utf8Chars.GetAllocatedSize( )
+		+ Sections.GetAllocatedSize( )
+		+ Entries.GetAllocatedSize( )
+		+ SectionIndexLevel.GetAllocatedSize( )
+		+ NameIndexLevel.GetAllocatedSize( )
+		+ Views.GetAllocatedSize( );
+}
+
+void IniViewCache::Reset( )
+{
+	FScopeLock ScopeLock( &Lock );
+	Strings.Empty( );
+}
+
+SIZE_T IniViewCache::GetAllocatedSize( ) const
+{
+	FScopeLock ScopeLock( &Lock );
+	SIZE_T Size = Strings.GetAllocatedSize( );
+	for (const TPair<uint64, FString>& String : Strings)
+	{
+		Size += String.Value.GetAllocatedSize( );
+	}
+	return Size;
+}
+
+uint32 IniRoot::HashName( const TCHAR* Str, int32 Len )
+{
+	// case-insensitive FNV-1a, keys compare the same way FString does
+	uint32 Hash = 2166136261u;
+	for (int32 i = 0; i < Len; ++i)
+	{
+		Hash = (Hash ^ (uint32)FChar::ToLower( Str[i] )) * 16777619u;
+	}
+	return Hash;
+}
+
+uint32 IniRoot::HashName( const ANSICHAR* Str, int32 Len )
+{
+	// same for UTF-8, folding ASCII letters only
+	uint32 Hash = 2166136261u;
+	for (int32 i = 0; i < Len; ++i)
+	{
+		Hash = (Hash ^ (uint32)(uint8)FCharAnsi::ToLower( Str[i] )) * 16777619u;
+	}
+	return Hash;
+}
+
+uint32 IniRoot::InternName( const TCHAR* Str, int32 Len, uint32 Hash )
+{
+	return FIniNameTable::Get( ).Intern( FStringView( Str, Len ), Hash );
+}
+
+IniByteSource::IniByteSource( )
+	: Data( nullptr )
+	, Size( 0 )
+{
+}
+
+IniByteSource::~IniByteSource( )
+{
+}
+
+IniByteSourcePtr IniByteSource::Open( const FString& FilePath )
+{
+	IniByteSourcePtr Source = MakeShared<IniByteSource, ESPMode::ThreadSafe>( );
+	Source->Handle.Reset( FPlatformFileManager::Get( ).GetPlatformFile( ).OpenMapped( *FilePath ) );
+	if (Source->Handle && Source->Handle->GetFileSize( ) > 0)
+	{
+		Source->Region.Reset( Source->Handle->MapRegion( 0, Source->Handle->GetFileSize( ) ) );
+	}
+
+	int64 Size;
+	if (Source->Region)
+	{
+		Source->Data = Source->Region->GetMappedPtr( );
+		Size = Source->Region->GetMappedSize( );
+	}
+	else
+	{
+		// no mapped files on this platform, or an empty file: read it, still without converting it
+		Source->Region.Reset( );
+		Source->Handle.Reset( );
+		if (!FFileHelper::LoadFileToArray( Source->Bytes, *FilePath ))
+		{
+			return nullptr;
+		}
+		Source->Data = Source->Bytes.GetData( );
+		Size = Source->Bytes.Num( );
+	}
+
+	if (Size > MAX_int32)
+	{
+		UE_LOG( LogSimpleINI, Error, TEXT( "%s is too large to load" ), *FilePath );
+		return nullptr;
+	}
+	Source->Size = (int32)Size;
+	return Source;
+}
+
+void IniBatchLog::Restore( IniRoot& Root ) const
+{
+	if (Root.IsUtf8( ))
+	{
+		Root.Utf8Chars.SetNum( NumChars, false );
+		Root.Views.Reset( );
+	}
+	else
+	{
+		Root.Chars.SetNum( NumChars, false );
+	}
+	Root.Sections.SetNum( NumSections, false );
+	Root.Entries.SetNum( NumEntries, false );
+	for (const TPair<int32, IniSection>& Saved : Sections)
+	{
+		Root.Sections[Saved.Key] = Saved.Value;
+	}
+	for (const TPair<int32, IniSectionContentEntry>& Saved : Entries)
+	{
+		Root.Entries[Saved.Key] = Saved.Value;
+	}
+
+	// chains may run through records that are gone
+	Root.SetBatchOpen( false );
+	Root.BuildIndex( );
+}
+
+bool IniTypedValue::ParseBool( const FString& Str, bool& OutValue )
+{
+	static const TCHAR* const TrueNames[] = { TEXT( "true" ), TEXT( "yes" ), TEXT( "on" ) };
+	static const TCHAR* const FalseNames[] = { TEXT( "false" ), TEXT( "no" ), TEXT( "off" ) };
+	for (int i = 0; i < UE_ARRAY_COUNT( TrueNames ); ++i)
+	{
+		if (Str.Equals( TrueNames[i], ESearchCase::IgnoreCase ) || Str.Equals( FalseNames[i], ESearchCase::IgnoreCase ))
+		{
+			OutValue = Str.Equals( TrueNames[i], ESearchCase::IgnoreCase );
+			return true;
+		}
+	}
+	float Number;
+	if (LexTryParseString( Number, *Str ))
+	{
+		OutValue = (Number != 0.0f);
+		return true;
+	}
+	return false;
+}
+
+template <typename FunctorType>
+bool IniValueCache::Get( const IniRoot& Root, FStringView SectionName, FStringView Name, uint8 Kind, bool& IsValid, FunctorType CopyOut ) const
+{
+	IsValid = false;
+	const int32 SectionIndex = Root.FindSection( SectionName );
+	const int32 EntryIndex = (SectionIndex != INDEX_NONE) ? Root.FindEntry( SectionIndex, Name ) : INDEX_NONE;
+	if (EntryIndex == INDEX_NONE)
+	{
+		return false;
+	}
+	const IniSectionContentEntry& Entry = Root.Entries[EntryIndex];
+	if (Entry.SubType != eNameValuePair)
+	{
+		return true;
+	}
+
+	{
+		FReadScopeLock ReadLock( Lock );
+		const IniTypedValue* Typed = Values.Find( EntryIndex );
+		if (Typed && (Typed->Parsed & Kind))
+		{
+			IsValid = (Typed->Valid & Kind) != 0;
+			if (IsValid)
+			{
+				CopyOut( *Typed );
+			}
+			return true;
+		}
+	}
+
+	FWriteScopeLock WriteLock( Lock );
+	IniTypedValue& Typed = Values.FindOrAdd( EntryIndex );
+	if (!(Typed.Parsed & Kind))
+	{
+		// another reader may have parsed it in between
+		FString Scratch;
+		ParseTyped( Root.GetString( Entry.Value, Scratch ), Kind, Typed );
+	}
+	IsValid = (Typed.Valid & Kind) != 0;
+	if (IsValid)
+	{
+		CopyOut( Typed );
+	}
+	return true;
+}
+
+bool IniValueCache::GetInt( const IniRoot& Root, FStringView SectionName, FStringView Name, int32& Val, bool& IsValid ) const
+{
+	return Get( Root, SectionName, Name, IniTypedValue::Int, IsValid, [&Val]( const IniTypedValue& Typed ) { Val = Typed.IntValue; } );
+}
+
+bool IniValueCache::GetFloat( const IniRoot& Root, FStringView SectionName, FStringView Name, float& Val, bool& IsValid ) const
+{
+	return Get( Root, SectionName, Name, IniTypedValue::Float, IsValid, [&Val]( const IniTypedValue& Typed ) { Val = Typed.FloatValue; } );
+}
+
+bool IniValueCache::GetBool( const IniRoot& Root, FStringView SectionName, FStringView Name, bool& Val, bool& IsValid ) const
+{
+	return Get( Root, SectionName, Name, IniTypedValue::Bool, IsValid, [&Val]( const IniTypedValue& Typed ) { Val = Typed.BoolValue; } );
+}
+
+bool IniValueCache::GetVector( const IniRoot& Root, FStringView SectionName, FStringView Name, FVector& Val, bool& IsValid ) const
+{
+	return Get( Root, SectionName, Name, IniTypedValue::Vector, IsValid, [&Val]( const IniTypedValue& Typed ) { Val = Typed.VectorValue; } );
+}
+
+bool IniValueCache::GetArray( const IniRoot& Root, FStringView SectionName, FStringView Name, TArray<FString>& Val, bool& IsValid ) const
+{
+	return Get( Root, SectionName, Name, IniTypedValue::Array, IsValid, [&Val]( const IniTypedValue& Typed ) { Val = Typed.ArrayValue; } );
+}
+
+void IniValueCache::Invalidate( int32 EntryIndex )
+{
+	FWriteScopeLock WriteLock( Lock );
+	Values.Remove( EntryIndex );
+}
+
+void IniValueCache::Reset( )
+{
+	FWriteScopeLock WriteLock( Lock );
+	Values.Empty( );
+}
+
+SIZE_T IniValueCache::GetAllocatedSize( ) const
+{
+	FReadScopeLock ReadLock( Lock );
+	return Values.GetAllocatedSize( );
 }
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "ini.h"
+#include "IniChangeNotifier.generated.h"
+
+// Delegates subscribed to a file, a section or a single key of the files opened
+// through USimpleINIBPLibrary. They fire on the game thread, once per value that
+// SetValue, a batch commit or a reload actually changed.
+class SIMPLEINI_API FIniChangeNotifier
+{
+public:
+	// FilePath is the normalized absolute path the file is registered under
+	DECLARE_MULTICAST_DELEGATE_TwoParams( FOnValueChanged, const FString& /*FilePath*/, const IniValueChange& /*Change*/ );
+
+	static FIniChangeNotifier& Get( );
+
+	// SectionName is empty for the lines in front of the first section
+	FDelegateHandle SubscribeFile( const FString& FilePath, const FOnValueChanged::FDelegate& Delegate );
+	FDelegateHandle SubscribeSection( const FString& FilePath, const FString& SectionName, const FOnValueChanged::FDelegate& Delegate );
+	FDelegateHandle SubscribeKey( const FString& FilePath, const FString& SectionName, const FString& Name, const FOnValueChanged::FDelegate& Delegate );
+	void Unsubscribe( FDelegateHandle Handle );
+
+	bool HasSubscribers( const FString& PathKey ) const;
+
+	// from any thread; other threads queue the changes for the game thread
+	void Broadcast( const FString& PathKey, TArray<IniValueChange>&& Changes );
+
+private:
+	struct FFileSubscribers
+	{
+		FOnValueChanged File;
+		TMap<FString, FOnValueChanged> Sections;
+		TMap<TPair<FString, FString>, FOnValueChanged> Keys;
+	};
+
+	// turns recording of the open file on or off to match whether it has subscribers
+	void UpdateRecording( const FString& PathKey ) const;
+
+	mutable FCriticalSection Lock;
+	TMap<FString, FFileSubscribers> Subscribers;
+};
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_FourParams( FOnIniValueChangedDynamic, const FString&, SectionName, const FString&, Key, const FString&, OldValue, const FString&, NewValue );
+
+// Blueprint side of a subscription, made by USimpleINIBPLibrary::SubscribeToIniChanges.
+// It stays subscribed until Unsubscribe or until it is garbage collected.
+UCLASS( BlueprintType )
+class SIMPLEINI_API UIniChangeSubscription : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	// a removed key reports an empty NewValue, an added one an empty OldValue
+	UPROPERTY( BlueprintAssignable, Category = "SimpleINI" )
+		FOnIniValueChangedDynamic OnValueChanged;
+
+	UFUNCTION( BlueprintCallable, Category = "SimpleINI" )
+		void Unsubscribe( );
+
+	void Subscribe( const FString& FilePath, const FString& SectionName, const FString& Key );
+	virtual void BeginDestroy( ) override;
+
+private:
+	void HandleValueChanged( const FString& FilePath, const IniValueChange& Change );
+
+	FDelegateHandle Handle;
+};
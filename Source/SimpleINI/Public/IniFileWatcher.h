@@ -0,0 +1,88 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/Future.h"
+#include "ini.h"
+
+// Reloads the files opened through USimpleINIBPLibrary when they change on disk and
+// reports each value that differs afterwards. Changes are noticed through inotify on
+// Linux and by polling size and time stamp elsewhere; a file is reloaded on the
+// thread pool once it stayed unchanged for the debounce time. Off until Start.
+class SIMPLEINI_API FIniFileWatcher
+{
+public:
+	// FilePath is the normalized absolute path the file is registered under
+	DECLARE_MULTICAST_DELEGATE_TwoParams( FOnValueChanged, const FString& /*FilePath*/, const IniValueChange& /*Change*/ );
+
+	static FIniFileWatcher& Get( );
+
+	void Start( float InDebounceSeconds = 0.25f );
+	// waits for reloads that are still running
+	void Stop( );
+	bool IsRunning( ) const { return TickHandle.IsValid( ); }
+
+	// broadcast on the game thread, once per changed value; FIniChangeNotifier
+	// subscribers hear of the same changes
+	FOnValueChanged& OnValueChanged( ) { return ValueChanged; }
+
+private:
+	struct FReloadResult
+	{
+		bool bRetry;		// the file could not be reloaded yet, e.g. a batch was open
+		TArray<IniValueChange> Changes;
+
+		FReloadResult( )
+			: bRetry( false )
+		{
+		}
+	};
+
+	struct FWatchedFile
+	{
+		IniFilePtr File;
+		int64 Size;
+		FDateTime TimeStamp;
+		double ChangeTime;		// when the file was last seen changing, 0 while nothing is pending
+		bool bPolled;			// no inotify watch covers it
+		int32 WatchDescriptor;	// inotify watch of its directory, -1 when polled
+		TFuture<FReloadResult> Reload;
+
+		FWatchedFile( )
+			: Size( -1 )
+			, ChangeTime( 0.0 )
+			, bPolled( true )
+			, WatchDescriptor( -1 )
+		{
+		}
+	};
+
+	struct FWatchedDirectory
+	{
+		FString Path;
+		int32 NumFiles;			// the watch is removed when the last of them goes
+	};
+
+	FIniFileWatcher( );
+	~FIniFileWatcher( );
+
+	bool Tick( float DeltaTime );
+	void SyncFiles( double Now );
+	void CheckFile( const FString& FilePath, FWatchedFile& Watched, double Now );
+	void ReadNotifications( double Now );
+	// the watch descriptor now covering the file's directory, -1 if it has to be polled
+	int32 WatchDirectory( const FString& FilePath );
+	void UnwatchDirectory( int32 WatchDescriptor );
+	// bReportChanges compares the documents to collect the changes, which parses a
+	// lazily loaded file whole; without it the file is reloaded as it was loaded
+	static FReloadResult ReloadFile( const IniFilePtr& File, bool bReportChanges );
+
+	FOnValueChanged ValueChanged;
+	FDelegateHandle TickHandle;
+	float DebounceSeconds;
+	double LastSyncTime;
+	TMap<FString, FWatchedFile> Files;
+
+	// inotify descriptor and its directory watches; -1 when polling
+	int32 NotifyFd;
+	TMap<int32, FWatchedDirectory> WatchedDirectories;
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "ini.h"
+
+// Several files read as one, e.g. Base, Platform and User: a key takes its value from
+// the last layer that has it. The merged values are kept in a single map, so a lookup
+// is one probe whatever the number of layers.
+//
+// The map is eventually consistent with the layers. It follows the changes
+// FIniChangeNotifier reports, which are delivered on the game thread: until then a
+// lookup, on any thread, returns the value from before a USimpleINIBPLibrary SetValue,
+// batch commit or reload made on another thread. Writes made on an IniFile directly
+// are never reported; call Refresh after them.
+class SIMPLEINI_API FIniLayeredConfig
+{
+public:
+	FIniLayeredConfig( )
+	{
+	}
+	~FIniLayeredConfig( );
+
+	FIniLayeredConfig( const FIniLayeredConfig& ) = delete;
+	FIniLayeredConfig& operator=( const FIniLayeredConfig& ) = delete;
+
+	// FilePaths from lowest to highest precedence. Files are opened through
+	// USimpleINIBPLibrary unless they are open already. A file that does not load adds
+	// nothing to the merged values; false when any did not.
+	bool Build( const TArray<FString>& FilePaths );
+	// Merges the layers again now, for changes FIniChangeNotifier did not report or has
+	// not delivered yet. Same result as Build.
+	bool Refresh( );
+	void Reset( );
+
+	bool GetValue( const FString& SectionName, const FString& Name, FString& Val, bool& IsValid ) const;
+	// the layer the value comes from, INDEX_NONE when no layer has the key
+	int32 GetValueLayer( const FString& SectionName, const FString& Name ) const;
+
+	int32 GetNumLayers( ) const { return LayerPaths.Num( ); }
+	// normalized path of a layer
+	const FString& GetLayerPath( int32 Layer ) const { return LayerPaths[Layer]; }
+
+private:
+	struct FMergedValue
+	{
+		FString Value;
+		int32 Layer;
+	};
+
+	void HandleValueChanged( const FString& FilePath, const IniValueChange& Change );
+
+	mutable FRWLock Lock;
+	TArray<FString> LayerPaths;
+	TMap<TPair<FString, FString>, FMergedValue> Values;
+	TArray<FDelegateHandle> Subscriptions;
+};
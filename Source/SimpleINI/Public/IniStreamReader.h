@@ -0,0 +1,41 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Callbacks of IniStreamReader, in file order. The views point into a buffer that is
+// reused for the next lines, so copy what has to outlive the call. Returning false
+// stops the read.
+class SIMPLEINI_API IniVisitor
+{
+public:
+	virtual ~IniVisitor( )
+	{
+	}
+
+	// the name between the brackets, trimmed
+	virtual bool OnSection( FStringView SectionName ) { return true; }
+	virtual bool OnKeyValue( FStringView Name, FStringView Value ) { return true; }
+	// a line with a name and no '='
+	virtual bool OnName( FStringView Name ) { return true; }
+	// the text after # or //, trimmed
+	virtual bool OnComment( FStringView Text ) { return true; }
+	virtual bool OnBlank( ) { return true; }
+};
+
+enum class EIniVisitResult : uint8
+{
+	Completed,
+	Stopped,		// a callback returned false
+	Failed,			// the file could not be read
+};
+
+// Reads ini text line by line without building an IniRoot. Lines are classified the way
+// IniFile parses them, but only a chunk of text and its line table are held at a time,
+// so memory does not grow with the file.
+namespace IniStreamReader
+{
+	// ChunkBytes of the file are read and converted at a time; a line longer than a chunk
+	// grows the buffer to fit it. UTF-16 files are converted whole before they are visited.
+	SIMPLEINI_API EIniVisitResult VisitFile( const FString& FilePath, IniVisitor& Visitor, int32 ChunkBytes = 64 * 1024 );
+	SIMPLEINI_API EIniVisitResult VisitText( FStringView Text, IniVisitor& Visitor );
+}
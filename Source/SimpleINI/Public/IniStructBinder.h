@@ -0,0 +1,71 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ini.h"
+
+class UStruct;
+class FProperty;
+
+// Maps the properties of a UStruct, or of a UClass, to the names of a section: each
+// property is found under its authored name, case-insensitively like any name. The
+// table and the text conversion of every property are worked out once, so a whole
+// struct is read or written in one pass over the section instead of a lookup and a
+// parse per property. Fixed size arrays, transient and deprecated properties are left
+// out; properties of other types go through their ImportText/ExportText format.
+class SIMPLEINI_API FIniStructBinder
+{
+public:
+	explicit FIniStructBinder( const UStruct* InStruct );
+
+	FIniStructBinder( const FIniStructBinder& ) = delete;
+	FIniStructBinder& operator=( const FIniStructBinder& ) = delete;
+
+	// the binder of Struct, built the first time it is asked for and shared by all threads;
+	// the reference stays valid as long as Struct is alive
+	static const FIniStructBinder& Get( const UStruct* Struct );
+	template <typename StructType>
+	static const FIniStructBinder& Get( )
+	{
+		return Get( StructType::StaticStruct( ) );
+	}
+
+	// Sets the properties of Data the section has a value for, the value a lookup of the
+	// name would find. Returns the number of properties set; a value that does not parse
+	// as its property's type leaves the property as it was.
+	int32 Import( const IniRoot& Root, int32 SectionIndex, void* Data ) const;
+	// name/text pairs of every mapped property, in property order
+	void Export( const void* Data, TArray<TPair<FString, FString>>& OutValues ) const;
+	// OutEntries lines up with the mapped properties: the entry a lookup of each name finds
+	// in the section, INDEX_NONE where there is none
+	void FindEntries( const IniRoot& Root, int32 SectionIndex, TArray<int32>& OutEntries ) const;
+
+	const UStruct* GetStruct( ) const { return Struct; }
+	int32 GetNumProperties( ) const { return Bindings.Num( ); }
+
+private:
+	typedef bool (*FImportFunc)( const FProperty* Property, void* Value, const FString& Text );
+	typedef void (*FExportFunc)( const FProperty* Property, const void* Value, FString& OutText );
+
+	struct FBinding
+	{
+		const FProperty* Property;
+		FString Name;
+		uint32 NameHash;		// IniRoot::HashName of Name, as entries store it
+		uint32 NameId;			// FIniNameTable id of Name
+		int32 HashNext;
+		// the same for compact documents, whose entries hash and compare names as UTF-8
+		TArray<ANSICHAR> Utf8Name;
+		uint32 Utf8NameHash;
+		int32 Utf8HashNext;
+		FImportFunc Import;
+		FExportFunc Export;
+	};
+
+	static void SelectConverter( const FProperty* Property, FBinding& Binding );
+
+	const UStruct* Struct;
+	TArray<FBinding> Bindings;
+	// hash buckets holding the last binding of each chain, by NameHash and by Utf8NameHash
+	TArray<int32> Buckets;
+	TArray<int32> Utf8Buckets;
+};
@@ -4,6 +4,8 @@
 
 #include "Modules/ModuleManager.h"
 
+DECLARE_LOG_CATEGORY_EXTERN( LogSimpleINI, Log, All );
+
 class FSimpleINIModule : public IModuleInterface
 {
 public:
@@ -3,7 +3,10 @@
 #pragma once
 
 #include "Kismet/BlueprintFunctionLibrary.h"
+#include "Engine/LatentActionManager.h"
+#include "Async/Future.h"
 #include "ini.h"
+#include "IniChangeNotifier.h"
 #include "SimpleINIBPLibrary.generated.h"
 
 /* 
@@ -31,26 +34,173 @@ class SIMPLEINI_API USimpleINIBPLibrary : public UBlueprintFunctionLibrary
 	//UFUNCTION(BlueprintCallable, meta = (DisplayName = "Execute Sample function", Keywords = "SimpleINI sample test testing"), Category = "SimpleINITesting")
 	//static float SimpleINISampleFunction(float Param);
 
+	// LazyParse reads only the section headers, and each section the first time it is used
 	UFUNCTION( BlueprintCallable, meta = (Keywords = "ini"), Category = "SimpleINI" )
-		static bool LoadIniFile( const FString& FilePath, bool ClearContent = false );
+		static bool LoadIniFile( const FString& FilePath, bool ClearContent = false, bool LazyParse = false );
+
+	// Loads many files at once, reading and parsing them in parallel. Loaded lines up
+	// with FilePaths; true when every file loaded.
+	UFUNCTION( BlueprintCallable, meta = (Keywords = "ini bulk parallel"), Category = "SimpleINI" )
+		static bool LoadIniFiles( const TArray<FString>& FilePaths, TArray<bool>& Loaded, bool ClearContent = false );
+
+	// Loads a binary image of the parsed file, written by an earlier load, when it is still
+	// current; rebuilds the image otherwise. An empty CacheDirectory keeps it next to the file.
+	UFUNCTION( BlueprintCallable, meta = (Keywords = "ini cache binary"), Category = "SimpleINI" )
+		static bool LoadIniFileCached( const FString& FilePath, const FString& CacheDirectory );
+
+	// Read-only load for very large files: maps the file and parses each section the
+	// first time it is read. SetValue and SaveIniFile fail on it.
+	UFUNCTION( BlueprintCallable, meta = (Keywords = "ini mapped large"), Category = "SimpleINI" )
+		static bool LoadIniFileMapped( const FString& FilePath );
+
+	// Keeps the text as UTF-8 instead of TCHARs, for large mostly ASCII files; the file
+	// stays compact across reloads.
+	UFUNCTION( BlueprintCallable, meta = (Keywords = "ini compact memory utf8"), Category = "SimpleINI" )
+		static bool LoadIniFileCompact( const FString& FilePath );
 
 	UFUNCTION( BlueprintCallable, meta = (Keywords = "ini"), Category = "SimpleINI" )
 		static bool GetValue( const FString& FilePath, const FString& SectionName, const FString& Key, FString& Value, bool& IsValid, bool CloseAfterFinish = false );
 
+	// Typed getters parse the value once and reuse the result until it changes.
+	// IsValid is false when the key has no value or it does not parse as the type.
+	UFUNCTION( BlueprintCallable, meta = (Keywords = "ini"), Category = "SimpleINI" )
+		static bool GetIntValue( const FString& FilePath, const FString& SectionName, const FString& Key, int32& Value, bool& IsValid, bool CloseAfterFinish = false );
+
+	UFUNCTION( BlueprintCallable, meta = (Keywords = "ini"), Category = "SimpleINI" )
+		static bool GetFloatValue( const FString& FilePath, const FString& SectionName, const FString& Key, float& Value, bool& IsValid, bool CloseAfterFinish = false );
+
+	UFUNCTION( BlueprintCallable, meta = (Keywords = "ini"), Category = "SimpleINI" )
+		static bool GetBoolValue( const FString& FilePath, const FString& SectionName, const FString& Key, bool& Value, bool& IsValid, bool CloseAfterFinish = false );
+
+	// "X=1 Y=2 Z=3" or "1,2,3"
+	UFUNCTION( BlueprintCallable, meta = (Keywords = "ini"), Category = "SimpleINI" )
+		static bool GetVectorValue( const FString& FilePath, const FString& SectionName, const FString& Key, FVector& Value, bool& IsValid, bool CloseAfterFinish = false );
+
+	// comma separated, each item trimmed
+	UFUNCTION( BlueprintCallable, meta = (Keywords = "ini"), Category = "SimpleINI" )
+		static bool GetArrayValue( const FString& FilePath, const FString& SectionName, const FString& Key, TArray<FString>& Value, bool& IsValid, bool CloseAfterFinish = false );
+
+	// every key of a section; false if the section does not exist
+	UFUNCTION( BlueprintCallable, meta = (Keywords = "ini"), Category = "SimpleINI" )
+		static bool GetSection( const FString& FilePath, const FString& SectionName, TMap<FString, FString>& Values, bool CloseAfterFinish = false );
+
+	// Values and IsValid line up with Keys
+	UFUNCTION( BlueprintCallable, meta = (Keywords = "ini"), Category = "SimpleINI" )
+		static bool GetValues( const FString& FilePath, const FString& SectionName, const TArray<FString>& Keys, TArray<FString>& Values, TArray<bool>& IsValid, bool CloseAfterFinish = false );
+
+	// Reads the section into the properties of a struct named like its keys, in one pass
+	// over the section (see FIniStructBinder); NumSet counts the properties that took a value
+	UFUNCTION( BlueprintCallable, CustomThunk, meta = (CustomStructureParam = "Value", Keywords = "ini struct bind"), Category = "SimpleINI" )
+		static bool GetSectionAsStruct( const FString& FilePath, const FString& SectionName, int32& Value, int32& NumSet, bool CloseAfterFinish = false );
+	DECLARE_FUNCTION( execGetSectionAsStruct );
+
+	UFUNCTION( BlueprintCallable, meta = (Keywords = "ini object bind"), Category = "SimpleINI" )
+		static bool GetSectionAsObject( const FString& FilePath, const FString& SectionName, UObject* Object, int32& NumSet, bool CloseAfterFinish = false );
+
+	static bool GetIniStruct( const FString& FilePath, const FString& SectionName, const UStruct* Struct, void* Data, int32& NumSet, bool CloseAfterFinish = false );
+	template <typename StructType>
+	static bool GetIniStruct( const FString& FilePath, const FString& SectionName, StructType& Value, bool CloseAfterFinish = false )
+	{
+		int32 NumSet;
+		return GetIniStruct( FilePath, SectionName, StructType::StaticStruct( ), &Value, NumSet, CloseAfterFinish );
+	}
+
 	UFUNCTION( BlueprintCallable, meta = (Keywords = "ini"), Category = "SimpleINI" )
 		static bool SetValue( const FString& FilePath, const FString& SectionName, const FString& Key, const FString& Value, bool CloseAfterFinish = false );
 
+	// SetValue for every property of the struct whose text differs from the section's
+	UFUNCTION( BlueprintCallable, CustomThunk, meta = (CustomStructureParam = "Value", Keywords = "ini struct bind"), Category = "SimpleINI" )
+		static bool SetSectionFromStruct( const FString& FilePath, const FString& SectionName, const int32& Value, bool CloseAfterFinish = false );
+	DECLARE_FUNCTION( execSetSectionFromStruct );
+
+	UFUNCTION( BlueprintCallable, meta = (Keywords = "ini object bind"), Category = "SimpleINI" )
+		static bool SetSectionFromObject( const FString& FilePath, const FString& SectionName, UObject* Object, bool CloseAfterFinish = false );
+
+	static bool SetIniStruct( const FString& FilePath, const FString& SectionName, const UStruct* Struct, const void* Data, bool CloseAfterFinish = false );
+	template <typename StructType>
+	static bool SetIniStruct( const FString& FilePath, const FString& SectionName, const StructType& Value, bool CloseAfterFinish = false )
+	{
+		return SetIniStruct( FilePath, SectionName, StructType::StaticStruct( ), &Value, CloseAfterFinish );
+	}
+
+	// fails while a batch is open on the file, the batch is saved when it is committed
 	UFUNCTION( BlueprintCallable, meta = (Keywords = "ini"), Category = "SimpleINI" )
 		static bool SaveIniFile( const FString& FilePath, bool CloseAfterFinish = false );
 
+	// the open file's document as UTF-8 text, for the network or a save game, without writing the file
+	UFUNCTION( BlueprintCallable, meta = (Keywords = "ini serialize bytes"), Category = "SimpleINI" )
+		static bool SaveIniFileToBytes( const FString& FilePath, TArray<uint8>& Bytes );
+
 	UFUNCTION( BlueprintCallable, meta = (Keywords = "ini"), Category = "SimpleINI" )
 		static bool ReloadIniFile( const FString& FilePath );
 
 	UFUNCTION( BlueprintCallable, meta = (Keywords = "ini"), Category = "SimpleINI" )
 		static void CloseIniFile( const FString& FilePath );
 
-	static TSharedPtr<IniFile> FindFileOpened( const FString& FilePath );
+	// sections of an open file whose lines were parsed so far, for lazily loaded files
+	UFUNCTION( BlueprintCallable, meta = (Keywords = "ini lazy stats"), Category = "SimpleINI" )
+		static bool GetParsedSectionCount( const FString& FilePath, int32& ParsedSections, int32& TotalSections );
+
+	// Async versions: file I/O, parsing and serializing run on the thread pool.
+	// Concurrent loads of the same file share one read and parse; a reload always
+	// reads the file again.
+	static TSharedFuture<bool> LoadIniFileAsync( const FString& FilePath, bool ClearContent = false );
+	static TSharedFuture<bool> ReloadIniFileAsync( const FString& FilePath );
+	static TFuture<bool> SaveIniFileAsync( const FString& FilePath, bool CloseAfterFinish = false );
+
+	UFUNCTION( BlueprintCallable, meta = (Latent, LatentInfo = "LatentInfo", WorldContext = "WorldContextObject", DisplayName = "Load Ini File (Async)", Keywords = "ini"), Category = "SimpleINI" )
+		static void LoadIniFileLatent( UObject* WorldContextObject, const FString& FilePath, bool ClearContent, bool& Success, FLatentActionInfo LatentInfo );
+
+	UFUNCTION( BlueprintCallable, meta = (Latent, LatentInfo = "LatentInfo", WorldContext = "WorldContextObject", DisplayName = "Reload Ini File (Async)", Keywords = "ini"), Category = "SimpleINI" )
+		static void ReloadIniFileLatent( UObject* WorldContextObject, const FString& FilePath, bool& Success, FLatentActionInfo LatentInfo );
+
+	UFUNCTION( BlueprintCallable, meta = (Latent, LatentInfo = "LatentInfo", WorldContext = "WorldContextObject", DisplayName = "Save Ini File (Async)", Keywords = "ini"), Category = "SimpleINI" )
+		static void SaveIniFileLatent( UObject* WorldContextObject, const FString& FilePath, bool CloseAfterFinish, bool& Success, FLatentActionInfo LatentInfo );
+
+	// SetValue calls between BeginIniBatch and CommitIniBatch are written to the file
+	// once, at commit; CloseAfterFinish on them waits for the commit as well
+	UFUNCTION( BlueprintCallable, meta = (Keywords = "ini batch transaction"), Category = "SimpleINI" )
+		static bool BeginIniBatch( const FString& FilePath );
+
+	UFUNCTION( BlueprintCallable, meta = (Keywords = "ini batch transaction"), Category = "SimpleINI" )
+		static bool CommitIniBatch( const FString& FilePath, bool CloseAfterFinish = false );
+
+	UFUNCTION( BlueprintCallable, meta = (Keywords = "ini batch transaction"), Category = "SimpleINI" )
+		static void RollbackIniBatch( const FString& FilePath );
+
+	// GetValue on this file reads an immutable snapshot instead of taking the file lock,
+	// so it never waits for SetValue/Save running on other threads
+	UFUNCTION( BlueprintCallable, meta = (Keywords = "ini"), Category = "SimpleINI" )
+		static bool SetSnapshotReads( const FString& FilePath, bool bEnable );
+
+	// Reloads open files when they change on disk, once they stayed unchanged for
+	// DebounceSeconds. FIniFileWatcher::OnValueChanged reports the values that changed.
+	UFUNCTION( BlueprintCallable, meta = (Keywords = "ini watch reload"), Category = "SimpleINI" )
+		static void SetWatchFiles( bool bEnable, float DebounceSeconds = 0.25f );
+
+	// Fires OnValueChanged of the returned object whenever SetValue, a batch commit or a
+	// reload changes a value of Key, of any key in SectionName when Key is empty, or of
+	// any key in the file when both are empty. Keep a reference to the object.
+	UFUNCTION( BlueprintCallable, meta = (Keywords = "ini notify subscribe"), Category = "SimpleINI" )
+		static UIniChangeSubscription* SubscribeToIniChanges( const FString& FilePath, const FString& SectionName, const FString& Key );
+
+	static IniFilePtr FindFileOpened( const FString& FilePath );
+};
+
+// Batch for the scope of a C++ block: commits when it goes out of scope unless
+// Commit or Rollback ran first.
+class SIMPLEINI_API FIniBatchScope
+{
+public:
+	explicit FIniBatchScope( const FString& InFilePath, bool bInCloseAfterFinish = false );
+	~FIniBatchScope( );
+
+	bool Commit( );
+	void Rollback( );
+	bool IsActive( ) const { return bActive; }
 
 private:
-	static TArray<TSharedPtr<IniFile>> INIs;
+	FString FilePath;
+	bool bCloseAfterFinish;
+	bool bActive;
 };
@@ -1,9 +1,21 @@
 #pragma once
 #include "CoreMinimal.h"
-#include <vector>
+#include "HAL/CriticalSection.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "HAL/ThreadSafeCounter64.h"
+#include "Templates/Atomic.h"
+#include "Templates/RefCounting.h"
 
 
 // ini structure modeling
+//
+// The whole document lives in a handful of contiguous arrays owned by IniRoot:
+// the file text is loaded once into Chars, names and values are slices of it,
+// and sections and entries refer to each other by index instead of by shared
+// pointer. SetValue writes the new line over the old one when it fits and appends it
+// to Chars otherwise; the text is compacted once most of it is no longer used.
+// Section and key names are also interned process-wide (FIniNameTable), and the
+// index compares the ids instead of the text.
 
 enum LineType
 {
@@ -18,184 +30,734 @@ enum LineType
 	eRoot,
 };
 
-struct IniLine;
-struct IniSection;
-struct IniSectionContentEntry;
-using IndexLevel = TMap<FString, TSharedPtr<IniLine>>;
-
-struct IniLineContext
+// A slice of IniRoot::Chars
+struct IniStringRef
 {
-	TArray<FString>* RawLines;
-	int LineNo;
+	int32 Offset;
+	int32 Len;
 
-	std::vector<TSharedPtr<IniLine>> Value;
+	IniStringRef( )
+		: Offset( 0 )
+		, Len( 0 )
+	{
+	}
+	IniStringRef( int32 InOffset, int32 InLen )
+		: Offset( InOffset )
+		, Len( InLen )
+	{
+	}
+	IniStringRef Slice( int32 Start, int32 Count ) const
+	{
+		return IniStringRef( Offset + Start, Count );
+	}
 };
 
-struct IniLine
+// Where a line sits in the file it was loaded from or last saved to
+struct IniFileLine
 {
-	LineType Type;
-	FString Raw;
-
-	IniLine( LineType T )
-		: Type( T )
+	int32 Offset;			// byte offset of the text, INDEX_NONE if the line was never written
+	int32 Len;				// bytes of text, without the line terminator
+	bool bDirty;			// text changed since it was written
+
+	IniFileLine( )
+		: Offset( INDEX_NONE )
+		, Len( 0 )
+		, bDirty( false )
+	{
+	}
+	IniFileLine( int32 InOffset, int32 InLen )
+		: Offset( InOffset )
+		, Len( InLen )
+		, bDirty( false )
 	{
 	}
-	virtual ~IniLine( ) {}
 };
 
-struct IniComment : public IniLine
+struct IniScannedLine;
+
+// A name whose value differs between two versions of a document
+struct IniValueChange
 {
-	TSharedPtr<IniSectionContentEntry> BelongTo;
+	FString SectionName;		// empty for lines in front of the first section
+	FString Name;
+	FString OldValue;
+	FString NewValue;
+	bool bAdded;
+	bool bRemoved;
+
+	IniValueChange( )
+		: bAdded( false )
+		, bRemoved( false )
+	{
+	}
+};
 
-	FString Value;
+struct IniSectionContentEntry
+{
+	LineType SubType;		// eWhiteLine, eComment, eOnlyName or eNameValuePair
+	int32 Section;			// owning section
+	int32 Next;				// next entry of the same section, INDEX_NONE for the last one
+	int32 HashNext;			// next entry in the same NameIndexLevel bucket
+	uint32 NameHash;
+	uint32 NameId;			// FIniNameTable id of the name, NoName in compact documents
+
+	IniStringRef Raw;
+	IniStringRef Name;		// key of eOnlyName/eNameValuePair, text of eComment
+	IniStringRef Value;		// value of eNameValuePair
+	IniFileLine File;
 
-	IniComment( )
-		: IniLine( eComment )
+	IniSectionContentEntry( )
+		: SubType( eWhiteLine )
+		, Section( INDEX_NONE )
+		, Next( INDEX_NONE )
+		, HashNext( INDEX_NONE )
+		, NameHash( 0 )
+		, NameId( 0 )
 	{
 	}
-	~IniComment( ) {}
-	static TSharedPtr<IniComment> FromLineString( TSharedPtr<IniLineContext>& Context );
 };
-struct IniWhiteLine : public IniLine
+
+struct IniSection
 {
-	TSharedPtr<IniSectionContentEntry> BelongTo;
+	bool IsVirtual;			// lines in front of the first [section] header, always Sections[0]
+	int32 FirstEntry;
+	int32 LastEntry;
+	int32 NumEntries;
+	int32 HashNext;			// next section in the same SectionIndexLevel bucket
+	uint32 NameHash;
+	uint32 NameId;
+
+	IniStringRef Raw;		// header line, empty for the virtual section
+	IniStringRef Name;
+	IniFileLine File;
+
+	// Lines after the header, in the document text or the IniByteSource; the entries
+	// are only created from them by IniRoot::ParseSection.
+	bool bParsed;
+	int32 BodyStart;
+	int32 BodyLen;
 
-	IniWhiteLine( )
-		: IniLine( eWhiteLine )
+	IniSection( )
+		: IsVirtual( false )
+		, FirstEntry( INDEX_NONE )
+		, LastEntry( INDEX_NONE )
+		, NumEntries( 0 )
+		, HashNext( INDEX_NONE )
+		, NameHash( 0 )
+		, NameId( 0 )
+		, bParsed( true )
+		, BodyStart( 0 )
+		, BodyLen( 0 )
 	{
 	}
-	~IniWhiteLine( ) {}
-	static TSharedPtr<IniWhiteLine> FromLineString( TSharedPtr<IniLineContext>& Context );
 };
-struct IniOnlyName :public IniLine
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+// UTF-8 text of a file, memory mapped where the platform supports it and read into
+// memory elsewhere. Shared by an IniRoot and the snapshots copied from it.
+struct IniByteSource
 {
-	TSharedPtr<IniSectionContentEntry> BelongTo;
+	const uint8* Data;
+	int32 Size;
 
-	FString Value;
+	IniByteSource( );
+	~IniByteSource( );
 
-	IniOnlyName( )
-		: IniLine( eOnlyName )
-	{
-	}
-	~IniOnlyName( ) {}
-	static TSharedPtr<IniOnlyName> FromLineString( TSharedPtr<IniLineContext>& Context );
+	static TSharedPtr<IniByteSource, ESPMode::ThreadSafe> Open( const FString& FilePath );
+
+private:
+	TUniquePtr<IMappedFileHandle> Handle;
+	TUniquePtr<IMappedFileRegion> Region;	// released before Handle
+	TArray<uint8> Bytes;
 };
-struct IniNameValuePair : public IniLine
+
+typedef TSharedPtr<IniByteSource, ESPMode::ThreadSafe> IniByteSourcePtr;
+
+// Converted text of a compact document handed out as views, one copy per string.
+// The copies keep their address until Reset, so such views last as long as views
+// into Chars do. Copying a document leaves the copy with an empty cache.
+struct IniViewCache
 {
-	TSharedPtr<IniSectionContentEntry> BelongTo;
+	IniViewCache( ) {}
+	IniViewCache( const IniViewCache& ) {}
+	IniViewCache& operator=( const IniViewCache& ) { Reset( ); return *this; }
 
-	FString Name;
-	FString Value;
+	void Reset( );
+	SIZE_T GetAllocatedSize( ) const;
 
-	IniNameValuePair( )
-		: IniLine( eNameValuePair )
-	{
-	}
-	~IniNameValuePair( ) {}
-	static TSharedPtr<IniNameValuePair> FromLineString( TSharedPtr<IniLineContext>& Context );
+	mutable FCriticalSection Lock;
+	// keyed by offset and length of the string in Utf8Chars
+	TMap<uint64, FString> Strings;
 };
-struct IniSectionName : public IniLine
+
+struct IniRoot
 {
-	TSharedPtr<IniSection> BelongTo;
+	TArray<TCHAR> Chars;
+	// the text of a compact document, in place of Chars; see FromUtf8
+	TArray<uint8> Utf8Chars;
+	TArray<IniSection> Sections;
+	TArray<IniSectionContentEntry> Entries;
+
+	// hash buckets holding the most recently added section/entry of each chain
+	TArray<int32> SectionIndexLevel;
+	TArray<int32> NameIndexLevel;
+
+	// The file as it was when the IniFileLine offsets were taken. The offsets are
+	// only usable when every character of the text took one byte in the file.
+	bool bFileLayoutKnown;
+	int64 FileSize;
+	FDateTime FileTimeStamp;
+	// size of what the document was parsed from, for statistics
+	int64 SourceBytes;
 
-	FString Value;
+	IniRoot( )
+		: bFileLayoutKnown( false )
+		, FileSize( 0 )
+		, SourceBytes( 0 )
+		, FileOrigin( 0 )
+		, NumPendingSections( 0 )
+		, NumDeadChars( 0 )
+		, bBatchOpen( false )
+		, bUtf8( false )
+	{
+	}
+
+	// Takes ownership of the file text; every line, name and value is a slice of it.
+	// InFileOrigin is the size of the byte order mark the text was read after.
+	static TSharedPtr<IniRoot> FromBuffer( TArray<TCHAR>&& Text, int32 InFileOrigin = 0 );
+	// Same, but only the section headers are parsed and indexed; the lines of a section
+	// are parsed by ParseSection.
+	static TSharedPtr<IniRoot> FromBufferLazy( TArray<TCHAR>&& Text, int32 InFileOrigin = 0 );
+	// Reads only the section headers of the UTF-8 text after InFileOrigin; the lines of a
+	// section are converted and parsed by ParseSection. The index is built.
+	static TSharedPtr<IniRoot> FromBytes( const IniByteSourcePtr& InSource, int32 InFileOrigin );
+	// Compact storage: takes ownership of the UTF-8 file bytes and keeps the text in them,
+	// a byte per ASCII character instead of a TCHAR. Names hash and compare as UTF-8, case
+	// folded for ASCII letters only. Lookups convert their keys on the way in and values
+	// are converted when they are copied out, or once into a cache for GetView and the
+	// lookups that return views; GetChars and the one argument GetString do not work on
+	// such a document. Every line is parsed;
+	// the index is not built.
+	static TSharedPtr<IniRoot> FromUtf8( TArray<uint8>&& Bytes, int32 InFileOrigin );
+	bool IsUtf8( ) const { return bUtf8; }
+
+	// Sections whose lines were not parsed yet can be looked up but have no entries.
+	// ParseSection adds to the document, so it needs the same exclusion as a change.
+	bool HasPendingSections( ) const { return NumPendingSections > 0; }
+	int32 GetNumPendingSections( ) const { return NumPendingSections; }
+	bool IsSectionParsed( int32 SectionIndex ) const { return Sections[SectionIndex].bParsed; }
+	void ParseSection( int32 SectionIndex );
+	void ParseAllSections( );
+	// ParseAllSections with runs of sections of about equal size parsed on the task
+	// graph and joined in order; the index is rebuilt once at the end. Sections read
+	// from an IniByteSource are parsed one after another.
+	void ParseAllSectionsParallel( );
+
+	// Reads or writes the whole document as the raw record arrays of a binary image.
+	// Writing needs every section parsed; loading leaves the archive in error when the
+	// image is cut short or does not describe a consistent document.
+	void SerializeImage( FArchive& Ar );
+
+	// Values a lookup finds in NewRoot but not in OldRoot, or finds with other text.
+	// Both documents need every section parsed.
+	static void Diff( const IniRoot& OldRoot, const IniRoot& NewRoot, TArray<IniValueChange>& OutChanges );
 
-	IniSectionName( )
-		: IniLine( eSectionName )
+	void BuildIndex( );
+	// Set while a batch is open. New records are still indexed but the bucket arrays do
+	// not grow, and SetEntryValue neither reuses nor compacts text, so the batch is undone
+	// by cutting the arrays back. Turning it off rebuilds the index once if it outgrew them.
+	void SetBatchOpen( bool bOpen );
+
+	int32 FindSection( FStringView SectionName ) const;
+	int32 FindEntry( int32 SectionIndex, FStringView Name ) const;
+	// same with the HashName of the name computed by the caller
+	int32 FindSection( FStringView SectionName, uint32 Hash ) const;
+	int32 FindEntry( int32 SectionIndex, FStringView Name, uint32 Hash ) const;
+	// same with the name interned by the caller; not for compact documents
+	int32 FindSectionById( uint32 Hash, uint32 NameId ) const;
+	int32 FindEntryById( int32 SectionIndex, uint32 Hash, uint32 NameId ) const;
+	// the entry a lookup finds, a name without value included; INDEX_NONE if there is none
+	int32 LookupEntry( FStringView SectionName, FStringView Name ) const;
+	bool GetValue( FStringView SectionName, FStringView Name, FStringView& Val, bool& IsValid ) const;
+	bool GetValue( FStringView SectionName, FStringView Name, FString& Val, bool& IsValid ) const;
+	// Name/value pairs of a section in file order, resolving the section once
+	bool GetSectionValues( FStringView SectionName, TArray<TPair<FStringView, FStringView>>& OutValues ) const;
+	// OutValues and OutValid line up with Names; the section is looked up once
+	bool GetValues( FStringView SectionName, const TArray<FString>& Names, TArray<FStringView>& OutValues, TArray<bool>& OutValid ) const;
+
+	int32 AddSection( FStringView SectionName );
+	int32 AddEntry( int32 SectionIndex, LineType SubType, IniStringRef Raw, IniStringRef Name, IniStringRef Value );
+	void SetEntryValue( int32 EntryIndex, FStringView Name, FStringView Val );
+
+	IniStringRef AddString( const TCHAR* Str, int32 Len );
+	const TCHAR* GetChars( IniStringRef Ref ) const
+	{
+		return Chars.GetData( ) + Ref.Offset;
+	}
+	FStringView GetString( IniStringRef Ref ) const
+	{
+		return FStringView( GetChars( Ref ), Ref.Len );
+	}
+	const ANSICHAR* GetUtf8Chars( IniStringRef Ref ) const
 	{
+		return (const ANSICHAR*)Utf8Chars.GetData( ) + Ref.Offset;
 	}
-	~IniSectionName( ) {}
-	static TSharedPtr<IniSectionName> FromLineString( TSharedPtr<IniLineContext>& Context );
+	// GetString for either storage; a compact document converts the text into Scratch
+	FStringView GetString( IniStringRef Ref, FString& Scratch ) const;
+	// GetString for either storage; a compact document converts the text once and keeps
+	// it until the next SetEntryValue, so the view outlives the call like a view into Chars
+	FStringView GetView( IniStringRef Ref ) const;
+	FString ToString( IniStringRef Ref ) const;
+	// size of Chars, or of Utf8Chars for a compact document
+	int32 GetTextLen( ) const { return bUtf8 ? Utf8Chars.Num( ) : Chars.Num( ); }
+	bool HasLines( ) const;
+
+	SIZE_T GetAllocatedSize( ) const;
+
+	static uint32 HashName( const TCHAR* Str, int32 Len );
+	static uint32 HashName( const ANSICHAR* Str, int32 Len );
+	// the FIniNameTable id of a name; compact documents do not intern their names
+	static uint32 InternName( const TCHAR* Str, int32 Len, uint32 Hash );
+	static uint32 InternName( const ANSICHAR* Str, int32 Len, uint32 Hash ) { return 0; }
+
+private:
+	// Text is Chars or Utf8Chars, the line offsets are relative to it
+	template <typename CharType>
+	void ParseLine( const CharType* Text, int32& SectionIndex, const IniScannedLine& Line, int32 InFileOrigin );
+	// entry for a line other than a section header, not linked or indexed yet
+	template <typename CharType>
+	void InitEntry( const CharType* Text, const IniScannedLine& Line, int32 InFileOrigin, IniSectionContentEntry& Entry ) const;
+	int32 AppendEntry( int32 SectionIndex, const IniSectionContentEntry& NewEntry );
+	template <typename CharType>
+	void AddPendingSections( const CharType* Text, int32 TextLen, const TArray<IniScannedLine>& Headers );
+	void IndexSection( int32 SectionIndex );
+	void IndexEntry( int32 EntryIndex );
+	// lookups in a compact document, with the key converted to UTF-8
+	int32 FindSectionUtf8( const ANSICHAR* SectionName, int32 Len ) const;
+	int32 FindEntryUtf8( int32 SectionIndex, const ANSICHAR* Name, int32 Len ) const;
+	// Moves the text of every record to the front of a new array, dropping what no
+	// record refers to. Only for a document without pending sections.
+	void CompactText( );
+
+	int32 FileOrigin;
+	int32 NumPendingSections;
+	IniByteSourcePtr Source;		// set when section bodies are read from it
+	int32 NumDeadChars;			// text no record refers to any more, see CompactText
+	bool bBatchOpen;
+	bool bUtf8;
+	IniViewCache Views;			// compact documents only
+
+	friend struct IniBatchLog;
 };
-struct IniSectionContentEntry : public IniLine
+
+// Undo record of a batch: how large the arrays were when it began, and the records
+// that existed then, saved the first time the batch changed them.
+struct IniBatchLog
 {
-	TSharedPtr<IniSection> BelongTo;
-	struct U
+	int32 NumChars;
+	int32 NumSections;
+	int32 NumEntries;
+	TMap<int32, IniSection> Sections;
+	TMap<int32, IniSectionContentEntry> Entries;
+	bool bChanged;
+	int32 NumRecordedChanges;
+	bool bHadUnsavedChanges;		// IniFile::HasUnsavedChanges when the batch began
+
+	IniBatchLog( const IniRoot& Root, int32 InNumRecordedChanges, bool bInHadUnsavedChanges )
+		: NumChars( Root.GetTextLen( ) )
+		, NumSections( Root.Sections.Num( ) )
+		, NumEntries( Root.Entries.Num( ) )
+		, bChanged( false )
+		, NumRecordedChanges( InNumRecordedChanges )
+		, bHadUnsavedChanges( bInHadUnsavedChanges )
 	{
-		TSharedPtr<IniNameValuePair> NVPair;
-		TSharedPtr<IniComment> Comment;
-		TSharedPtr<IniWhiteLine> WhiteLine;
-		TSharedPtr<IniOnlyName> OnlyName;
-	} Value;
-	LineType SubType;
+	}
 
-	IniSectionContentEntry( )
-		: IniLine( eSectionContentEntry )
+	void SaveSection( const IniRoot& Root, int32 SectionIndex )
 	{
+		if (SectionIndex < NumSections && !Sections.Contains( SectionIndex ))
+		{
+			Sections.Add( SectionIndex, Root.Sections[SectionIndex] );
+		}
 	}
-	~IniSectionContentEntry( ) {}
-	//static TSharedPtr<IniLine> FromLineString( );
+	void SaveEntry( const IniRoot& Root, int32 EntryIndex )
+	{
+		if (EntryIndex != INDEX_NONE && EntryIndex < NumEntries && !Entries.Contains( EntryIndex ))
+		{
+			Entries.Add( EntryIndex, Root.Entries[EntryIndex] );
+		}
+	}
+	void Restore( IniRoot& Root ) const;
 };
-struct IniSectionContent :public IniLine
-{
-	TSharedPtr<IniSection> BelongTo;
 
-	TArray<TSharedPtr<IniSectionContentEntry>> Entries;
-
-	IniSectionContent( )
-		:IniLine( eSectionContent )
+// A value parsed into the types the typed getters return. Each type is parsed the
+// first time it is asked for and kept until the value changes.
+struct IniTypedValue
+{
+	enum EKind : uint8
+	{
+		Int		= 1 << 0,
+		Float	= 1 << 1,
+		Bool	= 1 << 2,
+		Vector	= 1 << 3,
+		Array	= 1 << 4,
+	};
+
+	uint8 Parsed;		// EKind bits that were parsed
+	uint8 Valid;		// EKind bits whose parse succeeded
+	int32 IntValue;
+	float FloatValue;
+	bool BoolValue;
+	FVector VectorValue;
+	TArray<FString> ArrayValue;
+
+	IniTypedValue( )
+		: Parsed( 0 )
+		, Valid( 0 )
+		, IntValue( 0 )
+		, FloatValue( 0.0f )
+		, BoolValue( false )
+		, VectorValue( FVector::ZeroVector )
 	{
 	}
-	~IniSectionContent( ) {}
-	static TSharedPtr<IniSectionContent> FromLineString( TSharedPtr<IniLineContext>& Context );
+
+	// true/false, yes/no, on/off in any case, or a number that is not zero
+	static bool ParseBool( const FString& Str, bool& OutValue );
 };
-struct IniSection :public IniLine
+
+// Typed values keyed by entry index. Has its own lock, so readers sharing the
+// file's read lock can still fill it in.
+class IniValueCache
 {
-	bool IsVirtual;
-	TSharedPtr<IniSectionName> SectionName;
-	TSharedPtr<IniSectionContent> Content;
+public:
+	bool GetInt( const IniRoot& Root, FStringView SectionName, FStringView Name, int32& Val, bool& IsValid ) const;
+	bool GetFloat( const IniRoot& Root, FStringView SectionName, FStringView Name, float& Val, bool& IsValid ) const;
+	bool GetBool( const IniRoot& Root, FStringView SectionName, FStringView Name, bool& Val, bool& IsValid ) const;
+	bool GetVector( const IniRoot& Root, FStringView SectionName, FStringView Name, FVector& Val, bool& IsValid ) const;
+	bool GetArray( const IniRoot& Root, FStringView SectionName, FStringView Name, TArray<FString>& Val, bool& IsValid ) const;
 
-	IndexLevel NameIndexLevel;
+	void Invalidate( int32 EntryIndex );
+	void Reset( );
+	SIZE_T GetAllocatedSize( ) const;
 
-	IniSection( )
-		:IniLine( eSection )
-		,IsVirtual( false )
+private:
+	template <typename FunctorType>
+	bool Get( const IniRoot& Root, FStringView SectionName, FStringView Name, uint8 Kind, bool& IsValid, FunctorType CopyOut ) const;
+
+	mutable FRWLock Lock;
+	mutable TMap<int32, IniTypedValue> Values;
+};
+
+class FIniStructBinder;
+
+// Immutable copy of a document. Lookups never take the file's lock or wait for a
+// writer; only the caches of typed values and of compact views have locks of their
+// own. The copy is freed when the last IniSnapshotRef to it goes away.
+class IniSnapshot : public FRefCountBase
+{
+public:
+	explicit IniSnapshot( const IniRoot& InRoot )
+		: Root( InRoot )
 	{
 	}
-	~IniSection( ) {}
-	static TSharedPtr<IniSection> FromLineString( TSharedPtr<IniLineContext>& Context );
 
-	void BuildIndex( );
+	bool SectionExists( const FString& SectionName ) const;
+	bool NameExists( const FString& SectionName, const FString& Name ) const;
+	bool GetValue( const FString& SectionName, const FString& Name, FString& Val, bool& IsValid ) const;
+	bool GetValueView( const FString& SectionName, const FString& Name, FStringView& Val, bool& IsValid ) const;
+	bool GetSection( const FString& SectionName, TMap<FString, FString>& Values ) const;
+	bool GetValues( const FString& SectionName, const TArray<FString>& Names, TArray<FString>& Values, TArray<bool>& IsValid ) const;
+	bool GetStruct( const FString& SectionName, const FIniStructBinder& Binder, void* Data, int32& NumSet ) const;
+
+	bool GetInt( const FString& SectionName, const FString& Name, int32& Val, bool& IsValid ) const { return Cache.GetInt( Root, SectionName, Name, Val, IsValid ); }
+	bool GetFloat( const FString& SectionName, const FString& Name, float& Val, bool& IsValid ) const { return Cache.GetFloat( Root, SectionName, Name, Val, IsValid ); }
+	bool GetBool( const FString& SectionName, const FString& Name, bool& Val, bool& IsValid ) const { return Cache.GetBool( Root, SectionName, Name, Val, IsValid ); }
+	bool GetVector( const FString& SectionName, const FString& Name, FVector& Val, bool& IsValid ) const { return Cache.GetVector( Root, SectionName, Name, Val, IsValid ); }
+	bool GetArray( const FString& SectionName, const FString& Name, TArray<FString>& Val, bool& IsValid ) const { return Cache.GetArray( Root, SectionName, Name, Val, IsValid ); }
+
+private:
+	const IniRoot Root;
+	IniValueCache Cache;
 };
-struct IniRoot :public IniLine
-{
-	TArray<TSharedPtr<IniSection>> Lines;
-	IndexLevel SectionIndexLevel;
 
-	IniRoot( )
-		:IniLine( eRoot )
+typedef TRefCountPtr<IniSnapshot> IniSnapshotRef;
+
+// A section/name pair resolved once by IniFile::MakeKeyHandle. Lookups through it go
+// straight to the entry; after a reload or a rollback the entry is looked up again
+// with the stored hashes. A handle caches its entry, so share it between threads
+// only when the file is locked for writing around its use.
+struct IniKeyHandle
+{
+	FString SectionName;
+	FString Name;
+	uint32 SectionHash;
+	uint32 NameHash;
+	uint32 SectionId;		// FIniNameTable ids, NoName until some document has the name
+	uint32 NameId;
+	bool bVirtualSection;
+	int32 EntryIndex;
+	uint32 Generation;		// IniFile generation EntryIndex belongs to, 0 when never resolved
+
+	IniKeyHandle( )
+		: SectionHash( 0 )
+		, NameHash( 0 )
+		, SectionId( 0 )
+		, NameId( 0 )
+		, bVirtualSection( false )
+		, EntryIndex( INDEX_NONE )
+		, Generation( 0 )
 	{
 	}
-	~IniRoot( ) {}
-	static TSharedPtr<IniRoot> FromLineString( TSharedPtr<IniLineContext>& Context );
+};
 
-	void BuildIndex( );
+// What SimpleINI.DumpStats shows for a file: the counters since it was opened and
+// the size of the document it holds now
+struct IniFileStats
+{
+	int32 NumLoads;
+	int32 NumSaves;
+	int64 BytesRead;
+	int64 BytesWritten;
+	double LastParseSeconds;
+	double LastSaveSeconds;
+	int64 LookupHits;
+	int64 LookupMisses;
+	int32 NumGrowths;		// times the document's allocated size went up
+	int64 BytesGrown;		// sum of those increases
+
+	int32 NumSections;
+	int32 NumSectionsParsed;
+	int32 NumEntries;
+	int32 NumChars;
+	int32 NumSectionBuckets;
+	int32 NumNameBuckets;
+	SIZE_T AllocatedBytes;
+
+	IniFileStats( )
+		: NumLoads( 0 )
+		, NumSaves( 0 )
+		, BytesRead( 0 )
+		, BytesWritten( 0 )
+		, LastParseSeconds( 0.0 )
+		, LastSaveSeconds( 0.0 )
+		, LookupHits( 0 )
+		, LookupMisses( 0 )
+		, NumGrowths( 0 )
+		, BytesGrown( 0 )
+		, NumSections( 0 )
+		, NumSectionsParsed( 0 )
+		, NumEntries( 0 )
+		, NumChars( 0 )
+		, NumSectionBuckets( 0 )
+		, NumNameBuckets( 0 )
+		, AllocatedBytes( 0 )
+	{
+	}
 };
 
 class IniFile
 {
 public:
-	IniFile( ){}
-	virtual ~IniFile( ) {};
-
-	bool LoadFile( const FString& FilePath, bool ClearContent = false );
+	IniFile( )
+		: LastParseSeconds( 0.0 )
+		, bReadOnly( false )
+		, bLazy( false )
+		, bUnsavedChanges( false )
+		, BatchDepth( 0 )
+		, Generation( 1 )
+		, bRecordChanges( false )
+		, AccountedBytes( 0 )
+		, bSnapshotReads( false )
+		, bCompactStorage( false )
+		, Snapshot( nullptr )
+		, SnapshotEpoch( 0 )
+	{
+	}
+	virtual ~IniFile( );
+
+	// bLazy parses only the section headers up front, each section on its first lookup
+	bool LoadFile( const FString& FilePath, bool ClearContent = false, bool bLazy = false );
+	// Read-only load for large files: the file is memory mapped and left in UTF-8, only
+	// section headers are read up front, and a section is parsed the first time it is
+	// looked up. SetValue, Save and batches fail on such a file.
+	bool LoadFileMapped( const FString& FilePath );
+	// Loads the parsed document from a binary image (.inib) when one exists for the
+	// file's current size, time stamp and CRC, and writes a new image otherwise. The
+	// image goes next to the file, or into CacheDir when it is given.
+	bool LoadFileCached( const FString& FilePath, const FString& CacheDir = FString( ) );
+	// Compact storage: LoadFile and reloads keep the text as UTF-8 (IniRoot::FromUtf8),
+	// a quarter of the text memory for ASCII files where TCHAR takes 4 bytes and half
+	// where it takes 2. Such documents are parsed whole and lookups convert their keys;
+	// the view getters convert each value they hand out once and keep the copy.
+	void SetCompactStorage( bool bEnable ) { bCompactStorage = bEnable; }
+	bool UsesCompactStorage( ) const { return bCompactStorage; }
 	bool Save( );
+	// The document as Save writes it, UTF-8 without BOM, for handing it to something other
+	// than its file. Parses pending sections; read-only files can be written this way too.
+	bool SaveToBytes( TArray<uint8>& OutBytes );
+	bool SaveToArchive( FArchive& Ar );
+	bool IsReadOnly( ) const { return bReadOnly; }
+	// the document was loaded with sections left to parse on first lookup
+	bool IsLazy( ) const { return bLazy; }
+	// true while the file on disk is the one last loaded or saved
+	bool IsSameAsFile( ) const { return Root && CanSaveInPlace( ); }
+	// SetValue changed the document since it was last loaded or saved
+	bool HasUnsavedChanges( ) const { return bUnsavedChanges; }
+	// Reload for the file watcher: installs NewRoot and reports which values it changed.
+	// Refuses while a batch is open or for read-only files.
+	bool ReloadWithChanges( const TSharedPtr<IniRoot>& NewRoot, double ParseSeconds, TArray<IniValueChange>& OutChanges );
+
+	// With recording on, SetValue and loads over an existing document remember every
+	// value they change, for whoever owns the file to hand to subscribers. Recording
+	// parses lazily loaded documents whole on reload, to compare them.
+	void SetRecordChanges( bool bEnable );
+	bool IsRecordingChanges( ) const { return bRecordChanges; }
+	// moves out what was recorded; nothing while a batch is open, a rollback takes it back
+	void TakeChanges( TArray<IniValueChange>& OutChanges );
+	// Lookups parse a pending section first, which changes the document: callers sharing
+	// the file take the write lock for lookups in sections that are not parsed yet.
+	bool IsSectionParsed( const FString& SectionName ) const;
+	// [section] headers in the document, and how many of them had their lines parsed
+	int32 GetNumSections( ) const;
+	int32 GetNumSectionsParsed( ) const;
+
+	// LoadFile split in two: ParseFile does the file read and the parse and touches
+	// no IniFile, so it can run on any thread; AdoptRoot installs its result.
+	static TSharedPtr<IniRoot> ParseFile( const FString& FilePath, bool ClearContent, double& OutParseSeconds, bool bLazy = false, bool bCompact = false );
+	static TSharedPtr<IniRoot> ParseBytes( const TArray<uint8>& Bytes, double& OutParseSeconds, bool bLazy = false );
+	// compact storage; UTF-16 text is converted anyway and parsed the usual way
+	static TSharedPtr<IniRoot> ParseBytesCompact( TArray<uint8>&& Bytes, double& OutParseSeconds );
+	bool AdoptRoot( const FString& FilePath, const TSharedPtr<IniRoot>& NewRoot, double ParseSeconds, bool bInReadOnly = false );
 
 	bool SectionExists( const FString& SectionName ) const;
 	bool NameExists( const FString& SectionName, const FString& Name ) const;
 
 	bool GetValue( const FString& SectionName, const FString& Name, FString& Val, bool& IsValid ) const;
+	// Val points into the document, or into text converted from a compact one, and stays
+	// valid until the next SetValue or LoadFile
+	bool GetValueView( const FString& SectionName, const FString& Name, FStringView& Val, bool& IsValid ) const;
+	// Whole section or many keys at once. Later duplicates of a name win, as in GetValue.
+	bool GetSection( const FString& SectionName, TMap<FString, FString>& Values ) const;
+	bool GetSectionView( const FString& SectionName, TArray<TPair<FStringView, FStringView>>& Values ) const;
+	bool GetValues( const FString& SectionName, const TArray<FString>& Names, TArray<FString>& Values, TArray<bool>& IsValid ) const;
+	// every value of the document keyed by section and name; parses pending sections
+	void GetAllValues( TMap<TPair<FString, FString>, FString>& Values ) const;
+	// Fills the properties Binder maps from the section's values, in one pass over its
+	// lines; NumSet counts the properties that took a value. False if there is no section.
+	bool GetStruct( const FString& SectionName, const FIniStructBinder& Binder, void* Data, int32& NumSet ) const;
+
+	// Typed getters parse a value once and keep the result until SetValue or a reload.
+	// IsValid is false when the key has no value or the value does not parse as the type.
+	// Bools accept true/false, yes/no, on/off and numbers; vectors accept "X=1 Y=2 Z=3"
+	// and "1,2,3"; arrays split on commas.
+	bool GetInt( const FString& SectionName, const FString& Name, int32& Val, bool& IsValid ) const;
+	bool GetFloat( const FString& SectionName, const FString& Name, float& Val, bool& IsValid ) const;
+	bool GetBool( const FString& SectionName, const FString& Name, bool& Val, bool& IsValid ) const;
+	bool GetVector( const FString& SectionName, const FString& Name, FVector& Val, bool& IsValid ) const;
+	bool GetArray( const FString& SectionName, const FString& Name, TArray<FString>& Val, bool& IsValid ) const;
+
 	bool SetValue( const FString& SectionName, const FString& Name, const FString& Val );
+	// SetValue for every property Binder maps whose text differs from the section's;
+	// the snapshot is published once
+	bool SetStruct( const FString& SectionName, const FIniStructBinder& Binder, const void* Data );
 	bool SetValueAndSave( const FString& SectionName, const FString& Name, const FString& Val );
 
+	// Handles skip hashing and name compares on repeated access to the same key.
+	// A handle for a key that does not exist yet finds it once SetValue added it.
+	IniKeyHandle MakeKeyHandle( const FString& SectionName, const FString& Name ) const;
+	bool GetValue( IniKeyHandle& Key, FString& Val, bool& IsValid ) const;
+	bool GetValueView( IniKeyHandle& Key, FStringView& Val, bool& IsValid ) const;
+	bool SetValue( IniKeyHandle& Key, const FString& Val );
+
+	// Groups SetValue calls: the snapshot is published, the hash index grown and the
+	// file written once, by the outermost CommitBatch. If that save fails, or on
+	// RollbackBatch, the document goes back to where the outermost BeginBatch found it.
+	// Batches nest; a reload drops the open batch.
+	bool BeginBatch( );
+	bool CommitBatch( bool bSave = true );
+	void RollbackBatch( );
+	bool IsInBatch( ) const { return BatchDepth > 0; }
+
+	// bytes held by the parsed document
+	SIZE_T GetAllocatedSize( ) const;
+	double GetLastParseSeconds( ) const { return LastParseSeconds; }
+	IniFileStats GetStats( ) const;
+
+	// IniFile does no locking itself; callers sharing a file across threads
+	// take this for reading around lookups and for writing around changes
+	FRWLock& GetLock( ) const { return Lock; }
+
+	// Snapshot reads: every LoadFile/SetValue publishes an immutable copy of the
+	// document, and readers on any thread use AcquireSnapshot without taking Lock.
+	// Each publish copies the whole document, so this suits files read far more often
+	// than they change. Changes still have to be serialized by the caller.
+	void SetSnapshotReads( bool bEnable );
+	bool UsesSnapshotReads( ) const { return bSnapshotReads; }
+	// latest published copy, null unless snapshot reads are enabled
+	IniSnapshotRef AcquireSnapshot( ) const;
+
 public:
 	FString mFilePath;
 
 protected:
-	bool Parse( );
+	void PublishSnapshot( );
+	// releases retired snapshots no reader can still reach; called with RetiredLock held
+	void ReclaimSnapshots( ) const;
+
+	// Save writes only the lines that changed when the file on disk is still the
+	// one the document was read from: a changed line that fits is overwritten and
+	// padded with blanks, everything from the first line that does not fit or was
+	// added is rewritten as a tail. Otherwise the whole file is written to a
+	// temporary file that then replaces it.
+	bool CanSaveInPlace( ) const;
+	bool SaveInPlace( );
+	bool SaveWhole( );
+
+	// SetValue without publishing the snapshot
+	void ApplyValue( const FString& SectionName, const FString& Name, const FString& Val );
+	int32 ResolveKey( IniKeyHandle& Key ) const;
+	void RecordChange( int32 SectionIndex, int32 EntryIndex, const FString& Name, const FString& Val );
+	void CountLookup( bool IsValid ) const;
+	// moves this file's share of the document memory stat to its current size
+	void UpdateMemoryStat( );
+	void ParsePendingSection( FStringView SectionName ) const;
 
 private:
-	TArray<FString> RawLines;
 	TSharedPtr<IniRoot> Root;
+	double LastParseSeconds;
+	mutable FRWLock Lock;
+	bool bReadOnly;
+	bool bLazy;
+	bool bUnsavedChanges;
+
+	int32 BatchDepth;
+	TUniquePtr<IniBatchLog> Batch;
+
+	IniValueCache Cache;
+	// bumped whenever entry indices may change meaning, which invalidates key handles
+	uint32 Generation;
+
+	bool bRecordChanges;
+	TArray<IniValueChange> RecordedChanges;
+
+	// lookups count under the read lock, from any number of threads
+	IniFileStats Stats;
+	mutable FThreadSafeCounter64 LookupHits;
+	mutable FThreadSafeCounter64 LookupMisses;
+	SIZE_T AccountedBytes;
+
+	bool bSnapshotReads;
+	bool bCompactStorage;
+	TAtomic<IniSnapshot*> Snapshot;		// owns one reference
+	mutable TAtomic<uint32> SnapshotEpoch;
+	mutable FThreadSafeCounter SnapshotReaders[2];
+	// replaced snapshots and the epoch they were retired in, each holding a reference
+	// until no reader that could have loaded it is left
+	mutable FCriticalSection RetiredLock;
+	mutable TArray<TPair<IniSnapshot*, uint32>> RetiredSnapshots;
+	mutable FThreadSafeCounter NumRetiredSnapshots;
 };
 
+typedef TSharedPtr<IniFile, ESPMode::ThreadSafe> IniFilePtr;